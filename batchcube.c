@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include "frameout.h"
+#include "cuberender.h"
+
+#define W 150
+#define H 55
+
+/*
+    === batch rendering ===
+
+    instead of spinning the cube live, this reads a list of orientations (one "A B C" per line,
+    lines starting with # are skipped) and renders every one of them as a frame.
+
+    frames don't depend on each other, so they're spread over worker threads, each with its own
+    renderer. finished frames land in a ring of slots (the reorder buffer) and the main thread writes
+    them out strictly in order. a worker that gets too far ahead of the writer waits for a free slot,
+    so memory stays at a few frames per worker no matter how long the script is.
+
+    usage: ./batchcube [-i angles.txt] [-o frames.txt] [-j threads] [-c 256|true] [-s braille|half]
+
+    reads stdin / writes stdout when -i / -o aren't given. cat the output to play it back.
+
+    =================================
+*/
+
+typedef struct {
+    float A, B, C;
+} orientation;
+
+typedef struct {
+    char *frame;
+    size_t len;
+    int ready;
+} slot;
+
+orientation *script;    // all the orientations, in order
+int frames;             // how many there are
+
+slot *slots;            // reorder buffer
+int nslots;
+int next_frame = 0;     // next frame a worker should pick up
+int written = 0;        // frames the writer is done with
+
+pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t slot_filled = PTHREAD_COND_INITIALIZER;
+pthread_cond_t slot_freed = PTHREAD_COND_INITIALIZER;
+
+int color_mode = CUBE_MONO;
+int sub_mode = CUBE_CELL;
+
+void* worker(void* args) {
+    cube_renderer* r = (cube_renderer*)args;
+
+    while (1) {
+        pthread_mutex_lock(&lock);
+        int f = next_frame;
+        if (f >= frames || !running) {
+            pthread_mutex_unlock(&lock);
+            break;
+        }
+        next_frame++;
+
+        // waiting for the writer to catch up if this frame's slot is still taken
+        while (f >= written + nslots && running) {
+            pthread_cond_wait(&slot_freed, &lock);
+        }
+        pthread_mutex_unlock(&lock);
+
+        if (!running) break;
+
+        r->A = script[f].A;
+        r->B = script[f].B;
+        r->C = script[f].C;
+
+        cube_renderer_clear(r);
+        cube_renderer_draw(r, CUBE_ALL_FACES);
+        size_t len = cube_renderer_frame(r);
+
+        slot* s = &slots[f % nslots];
+        memcpy(s->frame, r->render_buf, len);
+
+        pthread_mutex_lock(&lock);
+        s->len = len;
+        s->ready = 1;
+        pthread_cond_broadcast(&slot_filled);
+        pthread_mutex_unlock(&lock);
+    }
+
+    return NULL;
+}
+
+// reads "A B C" lines until the end of the file. returns the number of orientations, or -1 if there's
+// no memory for them
+int read_script(FILE *in) {
+    int cap = 256;
+    script = malloc(cap * sizeof(orientation));
+    if (!script) return -1;
+
+    char line[256];
+    int n = 0;
+    while (fgets(line, sizeof(line), in)) {
+        orientation o;
+        if (line[0] == '#' || sscanf(line, "%f %f %f", &o.A, &o.B, &o.C) != 3) continue;
+
+        if (n == cap) {
+            orientation *p = realloc(script, cap * 2 * sizeof(orientation));
+            if (!p) return -1; // script is still there (and the program exits anyway)
+            script = p;
+            cap *= 2;
+        }
+        script[n++] = o;
+    }
+    return n;
+}
+
+int main(int argc, char **argv) {
+
+    const char *in_path = NULL, *out_path = NULL;
+    int threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-i") == 0 && a + 1 < argc) in_path = argv[++a];
+        else if (strcmp(argv[a], "-o") == 0 && a + 1 < argc) out_path = argv[++a];
+        else if (strcmp(argv[a], "-j") == 0 && a + 1 < argc) threads = atoi(argv[++a]);
+        else if (strcmp(argv[a], "-c") == 0 && a + 1 < argc) {
+            a++;
+            if (strcmp(argv[a], "256") == 0) color_mode = CUBE_COLOR256;
+            if (strcmp(argv[a], "true") == 0) color_mode = CUBE_TRUECOLOR;
+        }
+        else if (strcmp(argv[a], "-s") == 0 && a + 1 < argc) {
+            a++;
+            if (strcmp(argv[a], "braille") == 0) sub_mode = CUBE_BRAILLE;
+            if (strcmp(argv[a], "half") == 0) sub_mode = CUBE_HALFBLOCK;
+        }
+    }
+    if (threads < 1) threads = 1;
+
+    FILE *in = in_path ? fopen(in_path, "r") : stdin;
+    if (!in) {
+        perror(in_path);
+        return 1;
+    }
+    frames = read_script(in);
+    if (in != stdin) fclose(in);
+    if (frames < 0) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    int fd = out_path ? open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644) : STDOUT_FILENO;
+    if (fd < 0) {
+        perror(out_path);
+        return 1;
+    }
+
+    // one renderer per worker, and a few slots per worker so nobody has to wait on a slow frame
+    cube_renderer *renderers = malloc(threads * sizeof(cube_renderer));
+    pthread_t *tids = malloc(threads * sizeof(pthread_t));
+
+    nslots = threads * 4;
+    slots = calloc(nslots, sizeof(slot));
+    if (!renderers || !tids || !slots) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    size_t frame_max = (W + 1) * H * (CUBE_SGR_MAX + 3);
+
+    for (int i = 0; i < nslots; i++) {
+        slots[i].frame = malloc(frame_max);
+        if (!slots[i].frame) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+    }
+    for (int i = 0; i < threads; i++) {
+        if (cube_renderer_init(&renderers[i], W, H, color_mode, sub_mode) != 0) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        renderers[i].decal = CUBE_HEART;
+    }
+
+    frameout out;
+    frameout_init(&out, fd, 0);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int i = 0; i < threads; i++) {
+        pthread_create(&tids[i], NULL, worker, &renderers[i]);
+    }
+
+    // writing the frames out in order as they come in
+    for (int f = 0; f < frames && running; f++) {
+        slot* s = &slots[f % nslots];
+
+        pthread_mutex_lock(&lock);
+        while (!s->ready && running) {
+            // ctrl-c can't wake a condition variable, so checking back every now and then
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += 100 * 1000000;
+            if (until.tv_nsec >= 1000000000) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&slot_filled, &lock, &until);
+        }
+        pthread_mutex_unlock(&lock);
+
+        if (!s->ready) break;
+
+        if (frameout_write(&out, s->frame, s->len) < 0) {
+            perror("write");
+            running = 0;
+        }
+
+        pthread_mutex_lock(&lock);
+        s->ready = 0;
+        written++;
+        pthread_cond_broadcast(&slot_freed);
+        pthread_mutex_unlock(&lock);
+    }
+
+    // in case of ctrl-c, waking up anyone still waiting for a slot so they see running == 0
+    pthread_mutex_lock(&lock);
+    running = 0;
+    pthread_cond_broadcast(&slot_freed);
+    pthread_mutex_unlock(&lock);
+
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    frameout_close(&out);
+    fprintf(stderr, "%d frames on %d threads in %.2fs (%.1f frames/s)\n",
+            written, threads, secs, secs > 0 ? written / secs : 0.0);
+
+    if (out_path) close(fd);
+
+    for (int i = 0; i < threads; i++) {
+        cube_renderer_free(&renderers[i]);
+    }
+    for (int i = 0; i < nslots; i++) {
+        free(slots[i].frame);
+    }
+    free(slots);
+    free(renderers);
+    free(tids);
+    free(script);
+    return 0;
+}
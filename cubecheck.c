@@ -0,0 +1,604 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cuberender.h"
+
+#define W 150
+#define H 55
+
+/*
+    === frame checker ===
+
+    renders a fixed set of orientations through a plain reference renderer (the loops companioncube.c
+    started out with, nothing clever) and through every faster path in cuberender, and compares the
+    frames cell by cell. it also times every path and compares that against a saved baseline.
+
+    it fails (exit code 1) when:
+        - a path has more cells differing from the reference in any frame than it's allowed, as a % of
+          the cells the cube covers (in the reference or the path's frame). the plain points path has to
+          match every cell. the threaded one too, apart from cells where two points were tied for nearest
+          (which one wins comes down to drawing order). approximate paths like temporal leave out the cells
+          next to an edge in the reference (the cube's outline, where faces meet, the decal's outline),
+          they round those a little differently, and are allowed about 1% of the rest
+        - a path got slower than the baseline by more than the allowed regression
+        - a shape added with cube_renderer_add_shape comes out different with points than with rays
+
+    speeds are saved as how many times faster than the reference a path is, not frames per second,
+    so a baseline made on one machine still means something on another.
+
+    usage: ./cubecheck [-b baseline] [-w] [-r regression %] [-m mismatch %] [-t seconds] [-n passes]
+
+        -b  baseline file (default cubecheck.baseline, the one checked in next to this file)
+        -w  write the results as the new baseline (the only time it gets written). without -w, a missing
+            baseline is a failure, so a slowdown can't quietly become the new normal
+        -r  allowed slowdown against the baseline in percent (default 25)
+        -m  allowed % of differing cells (of the ones that count) per frame for every path (default: per
+            path, see paths[])
+        -t  how long each path (and the reference) is timed for, going through the views over and over
+            (not the ones inside the cube, see TIMED). the median time of one go through them counts
+            (default 0.5)
+        -n  goes through the views at least this many times when timing (default 3)
+
+    =================================
+*/
+
+#define FRAMES 64
+
+typedef struct {
+    float A, B, C, camera_dist;
+    float spacing;          // fine enough that the points leave no gaps, or every path fills them its own way
+} view;
+
+view views[FRAMES];
+
+#define ZOOMED 12      // then some zoomed in, so the corners go past the screen edges
+#define INSIDE 4       // and the last few from inside the cube (it's 50 wide), where only the far walls show
+
+// the inside views are only checked for output, not timed. they're full redraws at a fine spacing, so they'd
+// take up most of the time and hide how fast the rest is (temporal mode's reuse above all)
+#define TIMED (FRAMES - INSIDE)
+
+// a smooth spin (so temporal mode gets frames that follow each other)
+void make_views() {
+    for (int f = 0; f < FRAMES; f++) {
+        int inside = f >= FRAMES - INSIDE;
+        int zoomed = !inside && f >= FRAMES - INSIDE - ZOOMED;
+        views[f].A = f * 0.1;
+        views[f].B = f * 0.1;
+        views[f].C = f * 0.01;
+        views[f].camera_dist = inside ? 15 : zoomed ? 65 : 90;
+        views[f].spacing = inside ? 0.1 : zoomed ? 0.2 : 0.5;
+    }
+}
+
+/*
+    === reference ===
+
+    the straightforward way: every point of every face, hole and heart, rotated with sin/cos each
+    time, z buffered. same as the old companioncube.c apart from checking x and y separately, lighting
+    only the points that show up (gcc used to do that on its own, but not reliably) and noting ties.
+*/
+
+float A, B, C, camera_dist, spacing;
+const float cube_width = 50;
+const float z1 = 40;
+const cube_point lightsource = {100, 100, -100};
+
+char shades[] = ".,-~:;=!*#$@";
+char shines[] = "@$#*!=;:~`,.";
+int shadelen = sizeof(shades)/sizeof(char);
+
+float ref_z[W * H];
+char ref_tie[W * H];    // two points were tied for nearest here, the one drawn first won
+int track_ties;         // only while making ref_frames
+
+float calcX(float i, float j, float k) {
+  return j * sin(A) * sin(B) * cos(C) - k * cos(A) * sin(B) * cos(C) +
+         j * cos(A) * sin(C) + k * sin(A) * sin(C) + i * cos(B) * cos(C);
+}
+
+float calcY(float i, float j, float k) {
+  return j * cos(A) * cos(C) + k * sin(A) * cos(C) -
+         j * sin(A) * sin(B) * sin(C) + k * cos(A) * sin(B) * sin(C) -
+         i * cos(B) * sin(C);
+}
+
+float calcZ(float i, float j, float k) {
+  return k * cos(A) * cos(B) - j * sin(A) * cos(B) + i * sin(B);
+}
+
+void calculatepoint(char *buf, float i, float j, float k, float nx, float ny, float nz, int type) {
+    float x = calcX(i, j, k);
+    float y = calcY(i, j, k);
+    float z = calcZ(i, j, k) + camera_dist;
+
+    float ooz = 1/z;
+
+    float xp = round(W/2 + z1 * x * ooz * 2);
+    float yp = round(H/2 + z1 * y * ooz);
+
+    if (xp < 0 || xp >= W || yp < 0 || yp >= H) return;
+
+    int idx = xp + yp * W;
+
+    if (ooz > ref_z[idx]) {
+        float rnx = calcX(nx, ny, nz);
+        float rny = calcY(nx, ny, nz);
+        float rnz = calcZ(nx, ny, nz);
+
+        float mag = sqrt(lightsource.x*lightsource.x + lightsource.y*lightsource.y + lightsource.z*lightsource.z);
+        float luminance = (rnx*lightsource.x + rny*lightsource.y + rnz*lightsource.z)/mag;
+
+        int shade_idx = (int)((luminance)*(shadelen - 1));
+        if (shade_idx < 0) shade_idx = 0;
+        if (shade_idx > shadelen - 1) shade_idx = shadelen - 1;
+
+        if (type == CUBE_NORMAL) {
+            ref_z[idx] = ooz;
+            buf[idx] = shades[shade_idx];
+        }
+        if (type == CUBE_SHINY) {
+            ref_z[idx] = ooz;
+            buf[idx] = shines[shade_idx];
+        }
+        if (type == CUBE_HOLE) {
+            buf[idx] = ' ';
+        }
+        if (track_ties) ref_tie[idx] = 0;
+    }
+    else if (track_ties && ooz == ref_z[idx]) ref_tie[idx] = 1; // the one drawn first stays
+}
+
+void reference(const view *v, char *buf) {
+    A = v->A;
+    B = v->B;
+    C = v->C;
+    camera_dist = v->camera_dist;
+    spacing = v->spacing;
+
+    memset(buf, ' ', W * H);
+    memset(ref_z, 0, sizeof(ref_z));
+    memset(ref_tie, 0, sizeof(ref_tie));
+
+    const float radius = cube_width * 0.75 / 2;
+    const float heartsize = cube_width * 0.25;
+    const float d = cube_width/2 + 0.1;
+
+    for (float i = -cube_width/2; i <= cube_width/2; i += spacing) {
+        for (float j = -cube_width/2; j <= cube_width/2; j += spacing) {
+            calculatepoint(buf, -i, j, -cube_width/2, 1, 0, 0, CUBE_NORMAL);
+            calculatepoint(buf, i, j, cube_width/2, 0, 0, 1, CUBE_NORMAL);
+            calculatepoint(buf, cube_width/2, j, -i, -1, 0, 0, CUBE_NORMAL);
+            calculatepoint(buf, -cube_width/2, j, i, 0, 0, -1, CUBE_NORMAL);
+            calculatepoint(buf, i, -cube_width/2, j, 0, -1, 0, CUBE_NORMAL);
+            calculatepoint(buf, i, cube_width/2, -j, 0, 1, 0, CUBE_NORMAL);
+        }
+    }
+
+    for (float i = -radius; i <= radius; i += spacing) {
+        for (float j = -radius; j <= radius; j += spacing) {
+            if (i*i + j*j <= radius*radius) {
+                calculatepoint(buf, -i, j, -d, 1, 0, 0, CUBE_HOLE);
+                calculatepoint(buf, i, j, d, 0, 0, 1, CUBE_HOLE);
+                calculatepoint(buf, d, j, -i, -1, 0, 0, CUBE_HOLE);
+                calculatepoint(buf, -d, j, i, 0, 0, -1, CUBE_HOLE);
+                calculatepoint(buf, i, -d, j, 0, -1, 0, CUBE_HOLE);
+                calculatepoint(buf, i, d, -j, 0, 1, 0, CUBE_HOLE);
+            }
+        }
+    }
+
+    for (float i = -heartsize; i <= heartsize; i += spacing) {
+        for (float j = -heartsize; j <= heartsize; j += spacing) {
+            float s = 2.0 / heartsize;
+            float x_h = i * s;
+            float y_h = j * s;
+
+            float term = (x_h * x_h + y_h * y_h - 1);
+            if (term * term * term - x_h * x_h * y_h * y_h * y_h <= 0) {
+                calculatepoint(buf, -i, -j, -d, 1, 0, 0, CUBE_SHINY);
+                calculatepoint(buf, i, -j, d, 0, 0, 1, CUBE_SHINY);
+                calculatepoint(buf, d, -j, -i, -1, 0, 0, CUBE_SHINY);
+                calculatepoint(buf, -d, -j, i, 0, 0, -1, CUBE_SHINY);
+                calculatepoint(buf, i, -d, j, 0, -1, 0, CUBE_SHINY);
+                calculatepoint(buf, i, d, -j, 0, 1, 0, CUBE_SHINY);
+            }
+        }
+    }
+}
+
+/*
+    === paths ===
+
+    every path gets start() once before going through the views in order, then render() for each.
+*/
+
+cube_renderer main_r;
+cube_renderer face_r[3]; // threaded path: one per pair of faces
+const int face_pairs[3] = {CUBE_FRONT | CUBE_BACK, CUBE_LEFT | CUBE_RIGHT, CUBE_TOP | CUBE_BOTTOM};
+
+void set_view(cube_renderer *r, const view *v) {
+    r->A = v->A;
+    r->B = v->B;
+    r->C = v->C;
+    r->camera_dist = v->camera_dist;
+    r->spacing = v->spacing;
+}
+
+void start_renderer(cube_renderer *r) {
+    cube_renderer_free(r);
+    if (cube_renderer_init(r, W, H, CUBE_MONO, CUBE_CELL) != 0) {
+        fprintf(stderr, "out of memory\n");
+        exit(2);
+    }
+    r->decal = CUBE_HEART;
+}
+
+void splat_start() {
+    start_renderer(&main_r);
+}
+
+void splat_render(const view *v, char *buf) {
+    set_view(&main_r, v);
+    cube_renderer_clear(&main_r);
+    cube_renderer_draw(&main_r, CUBE_ALL_FACES);
+    memcpy(buf, main_r.buf, W * H);
+}
+
+void temporal_start() {
+    start_renderer(&main_r);
+    main_r.temporal = 1;
+}
+
+void* draw_pair(void *args) {
+    int i = *(int *)args;
+    cube_renderer_clear(&face_r[i]);
+    cube_renderer_draw(&face_r[i], face_pairs[i]);
+    return NULL;
+}
+
+void threaded_start() {
+    start_renderer(&main_r);
+    for (int i = 0; i < 3; i++) start_renderer(&face_r[i]);
+}
+
+// like threadedcube.c: a renderer per pair of faces on its own thread, merged by depth
+void threaded_render(const view *v, char *buf) {
+    pthread_t threads[3];
+    int ids[3] = {0, 1, 2};
+
+    for (int i = 0; i < 3; i++) {
+        set_view(&face_r[i], v);
+        pthread_create(&threads[i], NULL, draw_pair, &ids[i]);
+    }
+    for (int i = 0; i < 3; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    cube_renderer_clear(&main_r);
+    for (int i = 0; i < 3; i++) {
+        cube_renderer_merge(&main_r, &face_r[i]);
+    }
+    memcpy(buf, main_r.buf, W * H);
+}
+
+void raycast_start() {
+    start_renderer(&main_r);
+    main_r.raycast = 1;
+}
+
+#define MAX_ROW_THREADS 16
+
+int row_threads;
+int row_ids[MAX_ROW_THREADS];
+
+void* cast_rows(void *args) {
+    cube_renderer_cast_rows(&main_r, *(int *)args, row_threads);
+    return NULL;
+}
+
+// ray cast mode with the rows spread over threads (every n-th row to the same one, so they all get
+// some of the cube)
+void rows_render(const view *v, char *buf) {
+    pthread_t threads[MAX_ROW_THREADS];
+
+    set_view(&main_r, v);
+    cube_renderer_clear(&main_r);
+    if (cube_renderer_cast_start(&main_r) != 0) {
+        fprintf(stderr, "out of memory\n");
+        exit(2);
+    }
+
+    for (int i = 0; i < row_threads; i++) {
+        row_ids[i] = i;
+        pthread_create(&threads[i], NULL, cast_rows, &row_ids[i]);
+    }
+    for (int i = 0; i < row_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    memcpy(buf, main_r.buf, W * H);
+}
+
+typedef struct {
+    const char *name;
+    void (*start)(void);
+    void (*render)(const view *v, char *buf);
+    int skip;               // which differing cells don't count (EXACT, TIES or EDGES)
+    float max_mismatch;     // % of the covered cells allowed to differ from the reference in a frame (the ones that count)
+} path;
+
+#define EXACT 0     // every cell counts
+#define TIES 1      // not the ones where two points were tied for nearest in the reference
+#define EDGES 2     // not the ones next to an edge in the reference
+
+// threaded: where two faces from different renderers land on a cell at the same depth (the points along
+//     the edge two faces share), the merge keeps the first renderer's, while drawing them together keeps
+//     whichever was drawn first
+// temporal, raycast: a ray through a cell's center doesn't always hit what the point that rounded to that
+//     cell was on. that's mostly along the edges, but where the decal's outline is steep it can move a
+//     cell past them
+path paths[] = {
+    {"splat", splat_start, splat_render, EXACT, 0},
+    {"threaded", threaded_start, threaded_render, TIES, 0},
+    {"temporal", temporal_start, splat_render, EDGES, 1},
+    {"raycast", raycast_start, splat_render, EDGES, 1},
+    {"rows", raycast_start, rows_render, EDGES, 1},
+};
+const int npaths = sizeof(paths)/sizeof(path);
+
+/*
+    === added shapes ===
+
+    the reference only knows the preset decal, so shapes added with cube_renderer_add_shape are checked by
+    comparing the points against ray casting instead (decaltype() puts the last shape on top, which is
+    what cube_renderer_add_shape promises). the shape is a square hole over the heart, which has to go
+    through it in both.
+*/
+
+int square_inside(const cube_shape *s, float u, float v) {
+    return fabsf(u) <= s->extent && fabsf(v) <= s->extent;
+}
+
+// renders view v into buf the plain way (raycast 0) or with rays, with the square added
+void shape_render(int raycast, const view *v, char *buf) {
+    start_renderer(&main_r);
+    cube_shape square = {square_inside, NULL, NULL, 5, CUBE_HOLE, 0};
+    cube_renderer_add_shape(&main_r, &square);
+    main_r.raycast = raycast;
+    set_view(&main_r, v);
+    cube_renderer_clear(&main_r);
+    cube_renderer_draw(&main_r, CUBE_ALL_FACES);
+    memcpy(buf, main_r.buf, W * H);
+}
+
+// % allowed. a bit more than the ray cast paths get against the reference: here the points are on the other
+// side too, and where the bigger hole is seen at a steep angle they leave the odd gap the back wall shows through
+#define SHAPE_MISMATCH 2
+
+/*
+    === running it ===
+*/
+
+char ref_frames[FRAMES][W * H];
+char ref_ties[FRAMES][W * H];
+
+// a cell is on an edge if anything around it in the reference is different from it
+int on_edge(const char *ref, int x, int y) {
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            int nx = x + dx, ny = y + dy;
+            if (nx < 0 || nx >= W || ny < 0 || ny >= H) continue;
+            if (ref[ny * W + nx] != ref[y * W + x]) return 1;
+        }
+    }
+    return 0;
+}
+
+// % of the covered cells that differ from the reference and count (returned), and that differ but
+// don't (*skipped). ties is the reference's ref_tie, only needed for TIES
+double mismatch(const char *buf, const char *ref, const char *ties, int skip, double *skipped) {
+    int covered = 0, skipped_diff = 0, diff = 0;
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            int i = y * W + x;
+            if (buf[i] == ' ' && ref[i] == ' ') continue;
+            covered++;
+            if (buf[i] == ref[i]) continue;
+            if ((skip == TIES && ties[i]) || (skip == EDGES && on_edge(ref, x, y))) skipped_diff++;
+            else diff++;
+        }
+    }
+    *skipped = covered ? 100.0 * skipped_diff / covered : 0;
+    return covered ? 100.0 * diff / covered : 0;
+}
+
+double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+#define MAX_PASSES 1000
+
+double min_time = 0.5;  // seconds each path gets timed for, at least
+int min_passes = 3;
+
+int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// median time to go through the timed views. goes through them again and again for at least min_time
+// (and min_passes times), so one slow pass (another process, a page fault, ...) doesn't count for much
+double time_path(void (*start)(void), void (*render)(const view *, char *)) {
+    static char buf[W * H];
+    static double times[MAX_PASSES];
+    int n = 0;
+    double spent = 0;
+
+    while (n < MAX_PASSES && (n < min_passes || spent < min_time)) {
+        if (start) start();
+        double t = now();
+        for (int f = 0; f < TIMED; f++) {
+            render(&views[f], buf);
+        }
+        times[n] = now() - t;
+        spent += times[n++];
+    }
+
+    qsort(times, n, sizeof(double), cmp_double);
+    return n % 2 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2;
+}
+
+// reads "name speedup" lines. returns the speedup for name, or 0 if it isn't there
+double baseline_for(const char *file, const char *name) {
+    FILE *in = fopen(file, "r");
+    if (!in) return 0;
+
+    char line[256], n[128];
+    double speedup, found = 0;
+    while (fgets(line, sizeof(line), in)) {
+        if (sscanf(line, "%127s %lf", n, &speedup) == 2 && strcmp(n, name) == 0) found = speedup;
+    }
+    fclose(in);
+    return found;
+}
+
+int main(int argc, char **argv) {
+
+    const char *baseline = "cubecheck.baseline";
+    int write_baseline = 0;
+    double max_regression = 25;
+    double mismatch_override = -1;
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-b") == 0 && a + 1 < argc) baseline = argv[++a];
+        else if (strcmp(argv[a], "-w") == 0) write_baseline = 1;
+        else if (strcmp(argv[a], "-r") == 0 && a + 1 < argc) max_regression = atof(argv[++a]);
+        else if (strcmp(argv[a], "-m") == 0 && a + 1 < argc) mismatch_override = atof(argv[++a]);
+        else if (strcmp(argv[a], "-t") == 0 && a + 1 < argc) min_time = atof(argv[++a]);
+        else if (strcmp(argv[a], "-n") == 0 && a + 1 < argc) min_passes = atoi(argv[++a]);
+    }
+    if (min_passes < 1) min_passes = 1;
+
+    row_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (row_threads < 2) row_threads = 2; // still goes through the split even on one core
+    if (row_threads > MAX_ROW_THREADS) row_threads = MAX_ROW_THREADS;
+
+    FILE *probe = fopen(baseline, "r");
+    int have_baseline = probe != NULL;
+    if (probe) fclose(probe);
+
+    make_views();
+
+    track_ties = 1;
+    for (int f = 0; f < FRAMES; f++) {
+        reference(&views[f], ref_frames[f]);
+        memcpy(ref_ties[f], ref_tie, W * H);
+    }
+    track_ties = 0;
+    double ref_time = time_path(NULL, reference);
+
+    // worst frame: differing cells that count, and that don't (only shown), as % of the covered cells
+    printf("%-10s %10s %16s %10s %10s  %s\n", "path", "ms/frame", "worst (skipped)", "speedup", "baseline", "result");
+    printf("%-10s %10.2f %16s %9.1fx %10s  %s\n", "reference", ref_time / TIMED * 1000, "-", 1.0, "-", "-");
+
+    int failed = 0;
+    double speedups[sizeof(paths)/sizeof(path)];
+
+    for (int p = 0; p < npaths; p++) {
+        path *pa = &paths[p];
+        float allowed = mismatch_override >= 0 ? mismatch_override : pa->max_mismatch;
+
+        // correctness
+        static char buf[W * H];
+        double worst = 0, worst_skipped = 0;
+        pa->start();
+        for (int f = 0; f < FRAMES; f++) {
+            pa->render(&views[f], buf);
+
+            double skipped;
+            double pct = mismatch(buf, ref_frames[f], ref_ties[f], pa->skip, &skipped);
+            if (pct > worst) worst = pct;
+            if (skipped > worst_skipped) worst_skipped = skipped;
+        }
+
+        // speed
+        double t = time_path(pa->start, pa->render);
+        speedups[p] = ref_time / t;
+        double base = baseline_for(baseline, pa->name);
+
+        // a slowdown has to show up again when timed right next to a fresh timing of the reference, so a
+        // noisy stretch on the machine (other processes, clock changes) doesn't fail the check on its own
+        for (int retry = 0; retry < 2 && base > 0 && speedups[p] < base * (1 - max_regression / 100); retry++) {
+            double r = time_path(NULL, reference);
+            t = time_path(pa->start, pa->render);
+            speedups[p] = r / t;
+        }
+
+        const char *result = "ok";
+        if (worst > allowed) {
+            result = "FAIL (output differs)";
+            failed = 1;
+        }
+        else if (base > 0 && speedups[p] < base * (1 - max_regression / 100)) {
+            result = "FAIL (slower than baseline)";
+            failed = 1;
+        }
+
+        char base_str[32] = "-";
+        if (base > 0) snprintf(base_str, sizeof(base_str), "%.1fx", base);
+
+        char worst_str[32];
+        snprintf(worst_str, sizeof(worst_str), "%.2f%% (%.0f%%)", worst, worst_skipped);
+
+        printf("%-10s %10.2f %16s %9.1fx %10s  %s\n", pa->name, t / TIMED * 1000, worst_str, speedups[p], base_str, result);
+    }
+
+    // added shapes, only checked for output
+    double shape_worst = 0, shape_edges = 0;
+    for (int f = 0; f < FRAMES; f++) {
+        static char points[W * H], rays[W * H];
+        shape_render(0, &views[f], points);
+        shape_render(1, &views[f], rays);
+
+        double edges;
+        double pct = mismatch(rays, points, NULL, EDGES, &edges);
+        if (pct > shape_worst) shape_worst = pct;
+        if (edges > shape_edges) shape_edges = edges;
+    }
+    char shape_str[32];
+    snprintf(shape_str, sizeof(shape_str), "%.2f%% (%.0f%%)", shape_worst, shape_edges);
+    printf("%-10s %10s %16s %10s %10s  %s\n", "shape", "-", shape_str, "-", "-",
+           shape_worst > SHAPE_MISMATCH ? "FAIL (output differs)" : "ok");
+    if (shape_worst > SHAPE_MISMATCH) failed = 1;
+
+    if (write_baseline) {
+        FILE *out = fopen(baseline, "w");
+        if (!out) {
+            perror(baseline);
+            return 2;
+        }
+        fprintf(out, "# how many times faster than the reference each path is (written by cubecheck -w, built with gcc -O2)\n");
+        for (int p = 0; p < npaths; p++) {
+            fprintf(out, "%s %.2f\n", paths[p].name, speedups[p]);
+        }
+        fclose(out);
+        printf("baseline written to %s\n", baseline);
+    }
+
+    else if (!have_baseline) {
+        printf("FAIL: no baseline at %s, speeds weren't checked (run with -w to make one)\n", baseline);
+        failed = 1;
+    }
+
+    cube_renderer_free(&main_r);
+    for (int i = 0; i < 3; i++) cube_renderer_free(&face_r[i]);
+
+    return failed;
+}
@@ -4,6 +4,8 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "frameout.h"
+
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -21,6 +23,7 @@ float A = 0, B = 0, C = 0;
 const int cube_width = 50; // how big the cube will look
 float z_buf[W * H];     // stores z values of points (for depth perception effects)
 char buf[W * H];        // stores characters to print
+char render_buf[W * H]; // the frame that gets written out
 int bg = ' ';           // background
 float spacing = 0.5;
 
@@ -96,7 +99,8 @@ void calculatepoint(float i, float j, float k, float nx, float ny, float nz, int
 
     idx = xp + yp * W;  // index calculation. 
 
-    if ((idx >= 0 && idx < W * H) && (ooz > z_buf[idx])) {
+    // x and y are checked on their own, otherwise a point off the left/right edge would wrap into the next row
+    if ((xp >= 0 && xp < W && yp >= 0 && yp < H) && (ooz > z_buf[idx])) {
         if (type == NORMAL) {
             z_buf[idx] = ooz;
             
@@ -122,12 +126,18 @@ void calculatepoint(float i, float j, float k, float nx, float ny, float nz, int
 }
 
 
-int main() {
+int main(int argc, char **argv) {
 
+    // -n: don't wait on a slow terminal, drop frames instead
+    int nonblocking = argc > 1 && strcmp(argv[1], "-n") == 0;
 
     printf("\x1b[2J"); // ANSI code to clear terminal
+    fflush(stdout);
+
+    frameout out;
+    frameout_init(&out, STDOUT_FILENO, nonblocking);
 
-    while (1) {
+    while (running) {
 
         // clearing both buf and z_buf
         memset(buf, bg, W * H * sizeof(char)); 
@@ -161,18 +171,19 @@ int main() {
         }
 
 
-        printf("\x1b[H"); // ANSI code to tell the cursor to return to the start position
-
-        // printing contents of buf[]
+        // putting contents of buf[] into render_buf[] (first column of every row is the line break)
         for (int i = 0; i < W * H; i++) {
             if (i % W == 0) {
-                putchar('\n');
+                render_buf[i] = '\n';
             }
             else {
-                putchar(buf[i]);
+                render_buf[i] = buf[i];
             }
         }
 
+        // home escape + frame go out in one write (or get dropped if the terminal is behind, see frameout.h)
+        frameout_write(&out, render_buf, W * H);
+
 
         // changing angles so that the cube rotates
         A += 0.1;
@@ -182,5 +193,7 @@ int main() {
         //usleep(8000); // <--- uncomment this to slow down the animation
         
     }
+
+    frameout_close(&out);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,1152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "cuberender.h"
+
+// short names, only in here (the header has the prefixed ones so they can't clash with a host program's)
+#define NORMAL CUBE_NORMAL
+#define SHINY CUBE_SHINY
+#define HOLE CUBE_HOLE
+#define MONO CUBE_MONO
+#define COLOR256 CUBE_COLOR256
+#define TRUECOLOR CUBE_TRUECOLOR
+#define CELL CUBE_CELL
+#define BRAILLE CUBE_BRAILLE
+#define HALFBLOCK CUBE_HALFBLOCK
+#define NO_DECAL CUBE_NO_DECAL
+#define CIRCLE CUBE_CIRCLE
+#define HEART CUBE_HEART
+#define OUTSIDE CUBE_OUTSIDE
+#define INSIDE CUBE_INSIDE
+#define EDGE CUBE_EDGE
+#define MAX_SHAPES CUBE_MAX_SHAPES
+#define FRONT CUBE_FRONT
+#define BACK CUBE_BACK
+#define RIGHT CUBE_RIGHT
+#define LEFT CUBE_LEFT
+#define TOP CUBE_TOP
+#define BOTTOM CUBE_BOTTOM
+#define ALL_FACES CUBE_ALL_FACES
+#define LEVELS CUBE_LEVELS
+#define SGR_MAX CUBE_SGR_MAX
+
+typedef cube_point point;
+typedef cube_shape shape;
+typedef cube_shapepoints shapepoints;
+typedef cube_cellsample cellsample;
+typedef cube_renderer renderer;
+
+static const char shades[] = ".,-~:;=!*#$@"; // shades (darkest to brightest)
+static const char shines[] = "@$#*!=;:~`,.";
+static const int shadelen = sizeof(shades)/sizeof(char);
+static const int bg = ' ';  // background
+
+// bit for each dot (row, column), laid out so cov[] is directly the braille code point offset
+static const unsigned char braille_bits[4][2] = {{0x01, 0x08}, {0x02, 0x10}, {0x04, 0x20}, {0x40, 0x80}};
+static const unsigned char half_bits[2][1] = {{0x01}, {0x02}};
+
+// ordered dithering thresholds (brightness needed for a dot to light up), so braille keeps the shading
+static const float bayer[4][2] = {{0.5/8, 4.5/8}, {6.5/8, 2.5/8}, {1.5/8, 5.5/8}, {7.5/8, 3.5/8}};
+
+/*
+    === color ===
+
+    each lit cell gets a color index in col_buf[] next to its char in buf[]. the index picks a
+    brightness level out of one of two ramps (gray for the cube, pink for the heart).
+
+    the escapes are built once up front. when the frame is put together, an escape is only written
+    when the color actually changes along the row, and the last color carries on past the line break.
+    faces are flat so a whole face is usually one color, which keeps frames close to the mono size.
+
+    =================================
+*/
+
+// maps an rgb color onto the closest entry of the 256-color palette (6x6x6 cube or the gray ramp)
+static int to_256(int r, int g, int b) {
+    if (r == g && g == b) {
+        int gray = (r - 8) / 10;
+        if (gray < 0) gray = 0;
+        if (gray > 23) gray = 23;
+        return 232 + gray;
+    }
+    return 16 + 36 * (r * 5 / 255) + 6 * (g * 5 / 255) + (b * 5 / 255);
+}
+
+static void init_colors(renderer *r) {
+    for (int l = 0; l < LEVELS; l++) {
+        float t = (l + 1) / (float)LEVELS;
+
+        int gray = 38 + t * 217;
+        int pr = 80 + t * 175, pg = 20 + t * 90, pb = 50 + t * 130;
+
+        int body = 1 + l;
+        int heart = 1 + LEVELS + l;
+
+        if (r->color_mode == COLOR256) {
+            r->sgr_len[body] = sprintf(r->sgr[body], "\x1b[38;5;%dm", 232 + l);
+            r->sgr_len[heart] = sprintf(r->sgr[heart], "\x1b[38;5;%dm", to_256(pr, pg, pb));
+        }
+        else {
+            r->sgr_len[body] = sprintf(r->sgr[body], "\x1b[38;2;%d;%d;%dm", gray, gray, gray);
+            r->sgr_len[heart] = sprintf(r->sgr[heart], "\x1b[38;2;%d;%d;%dm", pr, pg, pb);
+        }
+    }
+}
+
+// color index for a point with the given luminance (darkest level still shows, same as the '.' shade)
+static int color_of(float lum, int type) {
+    int level = (int)(lum * (LEVELS - 1));
+    if (level < 0) level = 0;
+    if (level > LEVELS - 1) level = LEVELS - 1;
+
+    return (type == SHINY ? 1 + LEVELS : 1) + level;
+}
+
+/*
+    === sub-cell mode ===
+
+    same points as before, but projected onto a grid sx times wider and sy times taller than the
+    terminal. depth is kept per dot in sub_z[], but what's lit is only one bit per dot, packed per char
+    in cov[]. turning a char's bits into a glyph is then just glyphs[cov[i]].
+
+    half blocks only have 2 dots so they're just coverage (color does the shading), braille dots are
+    dithered by brightness so it still looks shaded in mono.
+
+    =================================
+*/
+
+static void init_glyphs(renderer *r) {
+    for (int bits = 0; bits < 256; bits++) {
+        if (bits == 0) {
+            r->glyphs[bits][0] = bg;
+            r->glyph_len[bits] = 1;
+            continue;
+        }
+
+        int cp;
+        if (r->sub_mode == BRAILLE) {
+            cp = 0x2800 + bits;
+        }
+        else {
+            int half[4] = {' ', 0x2580, 0x2584, 0x2588}; // upper half, lower half, full block
+            cp = half[bits & 3];
+        }
+
+        // all of these are 3 bytes in utf-8
+        r->glyphs[bits][0] = 0xE0 | (cp >> 12);
+        r->glyphs[bits][1] = 0x80 | ((cp >> 6) & 0x3F);
+        r->glyphs[bits][2] = 0x80 | (cp & 0x3F);
+        r->glyph_len[bits] = 3;
+    }
+}
+
+static float lightpoint(const renderer *r, float nx, float ny, float nz);
+
+static unsigned char dot_bit(const renderer *r, int dx, int dy) {
+    return r->sub_mode == BRAILLE ? braille_bits[dy % 4][dx % 2] : half_bits[dy % 2][0];
+}
+
+// loads a point (already rotated, not lit yet) into the dot grid
+static void calculatesubpoint(renderer *r, float x, float y, float ooz, float nx, float ny, float nz, int type) {
+    int w = r->w, h = r->h, sx = r->sx, sy = r->sy;
+
+    int dx = round(w * sx / 2 + r->z1 * x * ooz * 2 * sx);
+    int dy = round(h * sy / 2 + r->z1 * y * ooz * sy);
+
+    if (dx < 0 || dx >= w * sx || dy < 0 || dy >= h * sy) return;
+
+    int didx = dx + dy * w * sx;
+    if (ooz <= r->sub_z[didx]) return;
+
+    int cell = dx / sx + (dy / sy) * w;
+    unsigned char bit = dot_bit(r, dx, dy);
+
+    if (type == HOLE) {
+        r->cov[cell] &= ~bit;
+        return;
+    }
+    r->sub_z[didx] = ooz;
+
+    float luminance = lightpoint(r, nx, ny, nz);
+
+    int lit = 1;
+    if (r->sub_mode == BRAILLE) {
+        float l = luminance < 0 ? 0 : (luminance > 1 ? 1 : luminance);
+        float brightness = type == SHINY ? 1 - 0.75 * l : 0.25 + 0.75 * l; // shiny is inverted, like shines[]
+        lit = brightness > bayer[dy % 4][dx % 2];
+    }
+
+    if (lit) r->cov[cell] |= bit;
+    else r->cov[cell] &= ~bit;
+
+    r->col_buf[cell] = color_of(luminance, type);
+}
+
+/*
+    === euler rotation coordinates ===
+
+    derived from the matrix equation (x, y, z) = R_x(A) * R_y(B) * R_z(C) * (i, j, k)
+
+    where R_x(A), R_y(B), R_z(C) are 3-d rotation matrices
+
+    =================================
+*/
+
+static float calcX(const renderer *r, float i, float j, float k) {
+  float A = r->A, B = r->B, C = r->C;
+  return j * sin(A) * sin(B) * cos(C) - k * cos(A) * sin(B) * cos(C) +
+         j * cos(A) * sin(C) + k * sin(A) * sin(C) + i * cos(B) * cos(C);
+}
+
+static float calcY(const renderer *r, float i, float j, float k) {
+  float A = r->A, B = r->B, C = r->C;
+  return j * cos(A) * cos(C) + k * sin(A) * cos(C) -
+         j * sin(A) * sin(B) * sin(C) + k * cos(A) * sin(B) * sin(C) -
+         i * cos(B) * sin(C);
+}
+
+static float calcZ(const renderer *r, float i, float j, float k) {
+  float A = r->A, B = r->B;
+  return k * cos(A) * cos(B) - j * sin(A) * cos(B) + i * sin(B);
+}
+
+// value for how much light is hitting a surface with normal (nx, ny, nz) (between 0 and 1)
+static float lightpoint(const renderer *r, float nx, float ny, float nz) {
+    // calculating rotated normal coordinates
+    float rnx = calcX(r, nx, ny, nz);
+    float rny = calcY(r, nx, ny, nz);
+    float rnz = calcZ(r, nx, ny, nz);
+
+    point l = r->lightsource;
+    float mag = sqrt(l.x*l.x + l.y*l.y + l.z*l.z);
+    return (rnx*l.x + rny*l.y + rnz*l.z)/mag;
+}
+
+// picks the char (and color) for a cell from how lit it is
+static void shadecell(renderer *r, int idx, float luminance, int type) {
+    if (type == HOLE) {
+        r->buf[idx] = bg;
+        r->col_buf[idx] = 0;
+        return;
+    }
+
+    int shade_idx = (int)((luminance)*(shadelen - 1)); // assigning a value between 0 and (shadelen - 1) to get a shade
+    if (shade_idx < 0) shade_idx = 0; // darkest case
+    if (shade_idx > shadelen - 1) shade_idx = shadelen - 1; // brightest case
+
+    r->buf[idx] = type == SHINY ? shines[shade_idx] : shades[shade_idx];
+    r->col_buf[idx] = color_of(luminance, type);
+}
+
+// keeps what ended up in a cell around for the next frame (temporal mode)
+static void keepcell(renderer *r, int idx, int face, float i, float j, float k, int type) {
+    if (!r->cells) return;
+
+    r->cells[idx].p = (point){i, j, k};
+    r->cells[idx].face = face;
+    r->cells[idx].type = type;
+}
+
+// takes the rotated coordinates and applies shading + loads chars into buf[]
+// (everything that decides whether the point shows up at all comes first, lighting is only done for points that do)
+
+static void calculatepoint(renderer *r, int face, float i, float j, float k, float nx, float ny, float nz, int type) {
+    float x = calcX(r, i, j, k);
+    float y = calcY(r, i, j, k);
+    float z = calcZ(r, i, j, k) + r->camera_dist;
+
+    if (z < r->near_z) return; // too close to (or behind) the camera
+
+    float ooz = 1/z;    // one over z
+
+    if (r->sub_mode != CELL) {
+        calculatesubpoint(r, x, y, ooz, nx, ny, nz, type);
+        return;
+    }
+
+    // W/2 and H/2 are added so that the cube stays centered
+
+    float xp = round(r->w/2 + r->z1 * x * ooz * 2); // 2 is multiplied because the height of ASCII characters is usually 2x their width
+    float yp = round(r->h/2 + r->z1 * y * ooz);
+
+    // x and y are checked on their own, otherwise a point off the left/right edge would wrap into the next row
+    if (xp < 0 || xp >= r->w || yp < 0 || yp >= r->h) return;
+
+    int idx = xp + yp * r->w;  // index calculation.
+
+    if (ooz <= r->z_buf[idx]) return; // something closer is already there
+
+    keepcell(r, idx, face, i, j, k, type);
+
+    if (type == HOLE) { // holes just clear the cell, whatever is in the hole gets drawn on top
+        shadecell(r, idx, 0, HOLE);
+        return;
+    }
+
+    r->z_buf[idx] = ooz;
+    shadecell(r, idx, lightpoint(r, nx, ny, nz), type);
+}
+
+// position p and normal n of point (i, j) on one face of a cube whose faces are d away from the center
+static void faceposition(int face, float i, float j, float d, point *p, point *n) {
+    switch (face) {
+        case FRONT:  *p = (point){-i, j, -d}; *n = (point){1, 0, 0}; break;   // front    (+z)
+        case BACK:   *p = (point){i, j, d};   *n = (point){0, 0, 1}; break;   // back     (-z)
+        case RIGHT:  *p = (point){d, j, -i};  *n = (point){-1, 0, 0}; break;  // right    (+x)
+        case LEFT:   *p = (point){-d, j, i};  *n = (point){0, 0, -1}; break;  // left     (-x)
+        case TOP:    *p = (point){i, -d, j};  *n = (point){0, -1, 0}; break;  // top      (+y)
+        default:     *p = (point){i, d, -j};  *n = (point){0, 1, 0}; break;   // bottom   (-y)
+    }
+}
+
+// FRONT..BOTTOM -> 0..5
+static int faceindex(int face) {
+    int n = 0;
+    while (face > 1) {
+        face >>= 1;
+        n++;
+    }
+    return n;
+}
+
+static void facepoint(renderer *r, int face, float i, float j, float d, int type) {
+    point p, n;
+    faceposition(face, i, j, d, &p, &n);
+    calculatepoint(r, faceindex(face), p.x, p.y, p.z, n.x, n.y, n.z, type);
+}
+
+/*
+    === clipping ===
+
+    before any points of a face get calculated, its 4 corners are checked against the near plane and
+    the 4 planes through the camera and the screen edges (pushed out by GUARD cells so rounding
+    never cuts off a point that would've made it). if all 4 corners are on the wrong side of the same
+    plane the whole face is off screen and gets skipped. the planes are written as
+    (something * x + something * z) so they work for any z, without dividing by it.
+
+    faces that are only partly visible still go through, and calculatepoint throws away their
+    off screen points before doing any lighting.
+
+    =================================
+*/
+
+#define GUARD 2
+
+static int faceoffscreen(const renderer *r, int face) {
+    float half = r->cube_width / 2;
+    float d = half + 0.1 * (r->nshapes + 1); // far enough out to include the decals
+    float left = r->w/2 + GUARD, right = r->w - r->w/2 + GUARD;
+    float top = r->h/2 + GUARD, bottom = r->h - r->h/2 + GUARD;
+
+    int out_near = 1, out_left = 1, out_right = 1, out_top = 1, out_bottom = 1;
+
+    for (int c = 0; c < 4; c++) {
+        point p, n;
+        faceposition(face, c & 1 ? half : -half, c & 2 ? half : -half, d, &p, &n);
+
+        float x = calcX(r, p.x, p.y, p.z) * 2 * r->z1;  // 2 for the char aspect ratio, like in calculatepoint
+        float y = calcY(r, p.x, p.y, p.z) * r->z1;
+        float z = calcZ(r, p.x, p.y, p.z) + r->camera_dist;
+
+        if (z >= r->near_z) out_near = 0;
+        if (x >= -left * z) out_left = 0;
+        if (x <= right * z) out_right = 0;
+        if (y >= -top * z) out_top = 0;
+        if (y <= bottom * z) out_bottom = 0;
+    }
+
+    return out_near || out_left || out_right || out_top || out_bottom;
+}
+
+/*
+    === shapes ===
+
+    the points of a decal sit on a grid (spacing apart, from -extent to extent, both ways). instead of
+    testing every one of them, the grid is split into 4 boxes over and over (quadtree). a box the
+    bound test says is all inside gets all its points taken, one that's all outside gets skipped, and
+    only the boxes on the shape's edge get split further, down to single points tested with inside().
+    so the number of tests goes with the length of the shape's outline, not its area.
+
+    =================================
+*/
+
+// the bound tests leave this much room so they never disagree with inside() right on the edge
+#define BOUND_MARGIN 1e-4
+
+static int circle_inside(const shape *s, float u, float v) {
+    return u*u + v*v <= s->extent * s->extent;
+}
+
+static int circle_bound(const shape *s, float u0, float v0, float u1, float v1) {
+    // closest and furthest point of the box from the center
+    double nu = u0 > 0 ? u0 : (u1 < 0 ? u1 : 0), nv = v0 > 0 ? v0 : (v1 < 0 ? v1 : 0);
+    double fu = fmax(fabs(u0), fabs(u1)), fv = fmax(fabs(v0), fabs(v1));
+    double r2 = (double)s->extent * s->extent;
+
+    if (fu*fu + fv*fv < r2 * (1 - BOUND_MARGIN)) return INSIDE;
+    if (nu*nu + nv*nv > r2 * (1 + BOUND_MARGIN)) return OUTSIDE;
+    return EDGE;
+}
+
+static int heart_inside(const shape *s, float u, float v) {
+    float scale = 2.0 / s->extent;
+    float x_h = u * scale;
+    float y_h = v * scale;
+
+    float term = (x_h * x_h + y_h * y_h - 1);
+    return term * term * term - x_h * x_h * y_h * y_h * y_h <= 0;
+}
+
+// smallest and largest value of x^2 for x in [lo, hi]
+static void square_range(double lo, double hi, double *min, double *max) {
+    *max = fmax(lo * lo, hi * hi);
+    *min = (lo <= 0 && hi >= 0) ? 0 : fmin(lo * lo, hi * hi);
+}
+
+static int heart_bound(const shape *s, float u0, float v0, float u1, float v1) {
+    double scale = 2.0 / s->extent;
+    double x2lo, x2hi, y2lo, y2hi;
+    square_range(u0 * scale, u1 * scale, &x2lo, &x2hi);
+    square_range(v0 * scale, v1 * scale, &y2lo, &y2hi);
+
+    double y3lo = pow(v0 * scale, 3), y3hi = pow(v1 * scale, 3);
+
+    // (x^2 + y^2 - 1)^3 only goes up with x^2 + y^2
+    double t3lo = pow(x2lo + y2lo - 1, 3), t3hi = pow(x2hi + y2hi - 1, 3);
+
+    // x^2 * y^3, x^2 is never negative but y^3 can be
+    double p[4] = {x2lo * y3lo, x2lo * y3hi, x2hi * y3lo, x2hi * y3hi};
+    double plo = p[0], phi = p[0];
+    for (int i = 1; i < 4; i++) {
+        plo = fmin(plo, p[i]);
+        phi = fmax(phi, p[i]);
+    }
+
+    if (t3hi - plo < -BOUND_MARGIN) return INSIDE;
+    if (t3lo - phi > BOUND_MARGIN) return OUTSIDE;
+    return EDGE;
+}
+
+shape cube_circle_shape(float radius, int type) {
+    return (shape){circle_inside, circle_bound, NULL, radius, type, 0};
+}
+
+shape cube_heart_shape(float size, int type) {
+    return (shape){heart_inside, heart_bound, NULL, size, type, 1};
+}
+
+// marks the points inside the shape in the grid box [k0, k1] x [l0, l1] (indices into pos[])
+static void subdivide(renderer *r, const shape *s, const float *pos, int n, unsigned char *in,
+                      int k0, int k1, int l0, int l1) {
+    int result = EDGE;
+    if (s->bound && (k0 != k1 || l0 != l1)) {
+        result = s->bound(s, pos[k0], pos[l0], pos[k1], pos[l1]);
+        r->shape_tests++;
+    }
+
+    if (result == OUTSIDE) return;
+
+    if (result == INSIDE) {
+        for (int k = k0; k <= k1; k++) {
+            for (int l = l0; l <= l1; l++) in[k * n + l] = 1;
+        }
+        return;
+    }
+
+    // small enough (or nothing to split with), testing the points themselves
+    if (!s->bound || (k1 - k0 < 2 && l1 - l0 < 2)) {
+        for (int k = k0; k <= k1; k++) {
+            for (int l = l0; l <= l1; l++) {
+                in[k * n + l] = s->inside(s, pos[k], pos[l]);
+                r->shape_tests++;
+            }
+        }
+        return;
+    }
+
+    int km = (k0 + k1) / 2, lm = (l0 + l1) / 2;
+    subdivide(r, s, pos, n, in, k0, km, l0, lm);
+    if (lm < l1) subdivide(r, s, pos, n, in, k0, km, lm + 1, l1);
+    if (km < k1) subdivide(r, s, pos, n, in, km + 1, k1, l0, lm);
+    if (km < k1 && lm < l1) subdivide(r, s, pos, n, in, km + 1, k1, lm + 1, l1);
+}
+
+// works out which grid points are inside the shape. returns -1 if out of memory
+static int buildlayer(renderer *r, shapepoints *sp) {
+    const shape *s = &sp->s;
+
+    // grid positions, going the same way the plain loops did so the points come out exactly the same
+    int n = 0;
+    for (float i = -s->extent; i <= s->extent; i += r->spacing) n++;
+
+    float *pos = malloc(n * sizeof(float));
+    unsigned char *in = calloc(n * n, 1);
+    if (!pos || !in) {
+        free(pos);
+        free(in);
+        return -1;
+    }
+
+    int k = 0;
+    for (float i = -s->extent; i <= s->extent; i += r->spacing) pos[k++] = i;
+
+    if (n > 0) subdivide(r, s, pos, n, in, 0, n - 1, 0, n - 1);
+
+    int count = 0;
+    for (int i = 0; i < n * n; i++) count += in[i];
+
+    free(sp->uv);
+    sp->uv = malloc((count ? count : 1) * 2 * sizeof(float));
+    if (!sp->uv) {
+        free(pos);
+        free(in);
+        return -1;
+    }
+
+    sp->count = 0;
+    for (int k = 0; k < n; k++) {
+        for (int l = 0; l < n; l++) {
+            if (!in[k * n + l]) continue;
+            sp->uv[2 * sp->count] = pos[k];
+            sp->uv[2 * sp->count + 1] = pos[l];
+            sp->count++;
+        }
+    }
+
+    free(pos);
+    free(in);
+    return 0;
+}
+
+static void freelayers(renderer *r) {
+    for (int l = 0; l < r->nlayers; l++) {
+        free(r->layers[l].uv);
+    }
+    r->nlayers = 0;
+}
+
+// redoes the decal points if anything they depend on changed. returns -1 if out of memory
+static int updatelayers(renderer *r) {
+    if (r->layers_spacing == r->spacing && r->layers_width == r->cube_width &&
+        r->layers_decal == r->decal && r->layers_version == r->shapes_version) return 0;
+
+    freelayers(r);
+    r->shape_tests = 0;
+
+    float cube_width = r->cube_width;
+    shape todo[MAX_SHAPES + 2];
+    int n = 0;
+
+    // circle on each face (shiny on its own, a hole for the heart to go in otherwise)
+    if (r->decal == CIRCLE) todo[n++] = cube_circle_shape(cube_width * 0.75 / 2, SHINY);
+    if (r->decal == HEART) {
+        todo[n++] = cube_circle_shape(cube_width * 0.75 / 2, HOLE);
+        todo[n++] = cube_heart_shape(cube_width * 0.25, SHINY); // heart in each circle
+    }
+    for (int i = 0; i < r->nshapes; i++) todo[n++] = r->shapes[i];
+
+    for (int l = 0; l < n; l++) {
+        r->layers[l].s = todo[l];
+        r->layers[l].uv = NULL;
+        r->nlayers = l + 1;
+        if (buildlayer(r, &r->layers[l]) != 0) {
+            freelayers(r);
+            r->layers_spacing = 0;
+            return -1;
+        }
+    }
+
+    r->layers_spacing = r->spacing;
+    r->layers_width = r->cube_width;
+    r->layers_decal = r->decal;
+    r->layers_version = r->shapes_version;
+    return 0;
+}
+
+int cube_renderer_add_shape(renderer *r, const shape *s) {
+    if (r->nshapes == MAX_SHAPES) return -1;
+    r->shapes[r->nshapes++] = *s;
+    r->shapes_version++;
+    return 0;
+}
+
+void cube_renderer_clear_shapes(renderer *r) {
+    r->nshapes = 0;
+    r->shapes_version++;
+}
+
+/*
+    === temporal mode ===
+
+    from one frame to the next the cube only turns a little, so most cells show the same bit of the
+    cube as before, just moved. every cell remembers which point of the cube it showed (before
+    rotation). next frame that point is rotated with the new angles and projected again, and if it
+    lands close enough (tolerance) to a cell's center it's used there, relit with the new angles.
+
+    the cube is convex, so a point is still visible exactly when its face still points towards the
+    camera, and no depth sorting between faces is needed. cells inside the cube's outline that
+    nothing landed in (newly visible faces, stretched faces, points that missed their cell by too much)
+    get worked out on their own: a ray from the camera through the cell's center is intersected with
+    the cube (slab test), which gives the face and the point on it directly.
+
+    a full redraw happens every refresh_every frames, whenever the cube or decal changes, and on every
+    frame the camera is close enough to be inside the cube.
+
+    =================================
+*/
+
+// outward normals of FRONT..BOTTOM, in the same order as faceindex()
+static const point outward[6] = {{0, 0, -1}, {0, 0, 1}, {1, 0, 0}, {-1, 0, 0}, {0, -1, 0}, {0, 1, 0}};
+
+// rotation matrix for the current angles (m * p == (calcX(p), calcY(p), calcZ(p)))
+static void rotation(const renderer *r, float m[3][3]) {
+    for (int c = 0; c < 3; c++) {
+        float e[3] = {c == 0, c == 1, c == 2};
+        m[0][c] = calcX(r, e[0], e[1], e[2]);
+        m[1][c] = calcY(r, e[0], e[1], e[2]);
+        m[2][c] = calcZ(r, e[0], e[1], e[2]);
+    }
+}
+
+// what the decals make of point (i, j) on a face (the last shape it's inside of, like when drawing)
+static int decaltype(const renderer *r, int face, float i, float j) {
+    int type = NORMAL;
+
+    for (int l = 0; l < r->nlayers; l++) {
+        const shape *s = &r->layers[l].s;
+        float v = (s->flip_sides && face < 4) ? -j : j; // the side faces have the shape flipped
+        if (fabsf(i) <= s->extent && fabsf(v) <= s->extent && s->inside(s, i, v)) type = s->type;
+    }
+    return type;
+}
+
+// (i, j) of a point on a face, the other way around from faceposition()
+static void facecoords(int face, point p, float *i, float *j) {
+    switch (face) {
+        case 0: *i = -p.x; *j = p.y; break;
+        case 1: *i = p.x;  *j = p.y; break;
+        case 2: *i = -p.z; *j = p.y; break;
+        case 3: *i = p.z;  *j = p.y; break;
+        case 4: *i = p.x;  *j = p.z; break;
+        default: *i = p.x; *j = -p.z; break; // 5 (bottom)
+    }
+}
+
+// slab test: the ray o + t * dir is inside the cube between the last entry and the first exit of the 3
+// slabs. returns the face index it goes in through (or -1 for a miss) and the t it does so at.
+// when the way in is closer than near_z (the camera is inside the cube, or the near plane cuts into it)
+// it's the face the ray comes out through instead, seen from the inside, and that comes back as face + 6.
+// no branches (only selects), so a loop over a row of rays can be vectorized
+static inline float slabnear(float o, float d, float half, float *far) {
+    float tiny = signbit(d) ? -1e-9f : 1e-9f;
+    d = fabsf(d) < 1e-9f ? tiny : d; // parallel to the slab: t1 and t2 go huge, same sign if outside it
+    float t1 = (-half - o) / d;
+    float t2 = (half - o) / d;
+    *far = t1 < t2 ? t2 : t1;
+    return t1 < t2 ? t1 : t2;
+}
+
+static inline int raytest(const float o[3], const float dir[3], float half, float near_z, float *t) {
+    float fx, fy, fz;
+    float nx = slabnear(o[0], dir[0], half, &fx);
+    float ny = slabnear(o[1], dir[1], half, &fy);
+    float nz = slabnear(o[2], dir[2], half, &fz);
+
+    // entering through the - side of a slab when going +, and the other way around
+    // (signbit instead of < 0 and & instead of &&, so the compiler has no reason to turn anything into a branch)
+    int face_x = signbit(dir[0]) ? 2 : 3;   // right / left
+    int face_y = signbit(dir[1]) ? 5 : 4;   // bottom / top
+    int face_z = signbit(dir[2]) ? 1 : 0;   // back / front
+
+    int face = face_x;
+    float t_near = nx;
+    int later = ny > t_near;
+    face = later ? face_y : face;
+    t_near = later ? ny : t_near;
+    later = nz > t_near;
+    face = later ? face_z : face;
+    t_near = later ? nz : t_near;
+
+    // coming out through the + side of a slab when going +, so the other face of each pair
+    int out = face_x ^ 1;
+    float t_far = fx;
+    int sooner = fy < t_far;
+    out = sooner ? face_y ^ 1 : out;
+    t_far = sooner ? fy : t_far;
+    sooner = fz < t_far;
+    out = sooner ? face_z ^ 1 : out;
+    t_far = sooner ? fz : t_far;
+
+    // d.z is 1, so t is the z of the hit
+    int inside = t_near < near_z;
+    *t = inside ? t_far : t_near;
+    face = inside ? out + 6 : face;
+    int hit = (t_near <= t_far) & (t_far >= near_z);
+    return hit ? face : -1;
+}
+
+// intersects the ray through the center of cell (cx, cy) with the cube. returns the face index (or -1
+// for a miss), the point hit (before rotation) and its z
+static int castcell(const renderer *r, float m[3][3], int cx, int cy, point *hit, float *hit_z) {
+    // ray direction on screen, undoing the projection in calculatepoint (z = 1)
+    float d[3] = {(cx - r->w/2) / (2 * r->z1), (cy - r->h/2) / r->z1, 1};
+
+    // camera and ray in the cube's own (unrotated) coordinates: transposed matrix undoes the rotation
+    float o[3], dir[3];
+    for (int a = 0; a < 3; a++) {
+        o[a] = -r->camera_dist * m[2][a];
+        dir[a] = m[0][a] * d[0] + m[1][a] * d[1] + m[2][a] * d[2];
+    }
+
+    float t;
+    int face = raytest(o, dir, r->cube_width / 2, r->near_z, &t);
+    if (face < 0 || face >= 6) return -1; // from the inside only happens when cameranear(), and that's a full redraw
+
+    hit->x = o[0] + t * dir[0];
+    hit->y = o[1] + t * dir[1];
+    hit->z = o[2] + t * dir[2];
+    *hit_z = t;
+    return face;
+}
+
+// moves last frame's cells over and works out the rest
+static void drawtemporal(renderer *r) {
+    int w = r->w, h = r->h;
+
+    float m[3][3];
+    rotation(r, m);
+
+    // lighting and facing only depend on the face
+    float lum[6];
+    int facing[6];
+    for (int f = 0; f < 6; f++) {
+        point p, n;
+        faceposition(1 << f, 0, 0, 0, &p, &n);
+        lum[f] = lightpoint(r, n.x, n.y, n.z);
+
+        // the face's plane, seen from the camera: (m * outward) . (face center) < 0 means it points our way
+        float nz = m[2][0] * outward[f].x + m[2][1] * outward[f].y + m[2][2] * outward[f].z;
+        facing[f] = r->cube_width / 2 + r->camera_dist * nz < 0;
+    }
+
+    r->cells_reused = r->cells_cast = 0;
+
+    // moving last frame's cells to where they are now
+    for (int idx = 0; idx < w * h; idx++) {
+        cellsample c = r->prev_cells[idx];
+        if (c.face < 0 || !facing[(int)c.face]) continue;
+
+        float x = m[0][0] * c.p.x + m[0][1] * c.p.y + m[0][2] * c.p.z;
+        float y = m[1][0] * c.p.x + m[1][1] * c.p.y + m[1][2] * c.p.z;
+        float z = m[2][0] * c.p.x + m[2][1] * c.p.y + m[2][2] * c.p.z + r->camera_dist;
+        if (z < r->near_z) continue;
+
+        float ooz = 1/z;
+        float fx = w/2 + r->z1 * x * ooz * 2;
+        float fy = h/2 + r->z1 * y * ooz;
+        float xp = round(fx), yp = round(fy);
+
+        if (xp < 0 || xp >= w || yp < 0 || yp >= h) continue;
+        if (fabsf(fx - xp) > r->tolerance || fabsf(fy - yp) > r->tolerance) continue;
+
+        int to = xp + yp * w;
+        if (ooz <= r->z_buf[to]) continue;
+
+        r->z_buf[to] = ooz;
+        shadecell(r, to, lum[(int)c.face], c.type);
+        r->cells[to] = c;
+        r->cells_reused++;
+    }
+
+    // the cube's outline on screen (from its corners), anything outside of it stays empty
+    float half = r->cube_width / 2;
+    int x0 = w, x1 = -1, y0 = h, y1 = -1;
+    for (int c = 0; c < 8; c++) {
+        float p[3] = {c & 1 ? half : -half, c & 2 ? half : -half, c & 4 ? half : -half};
+        float x = m[0][0] * p[0] + m[0][1] * p[1] + m[0][2] * p[2];
+        float y = m[1][0] * p[0] + m[1][1] * p[1] + m[1][2] * p[2];
+        float z = m[2][0] * p[0] + m[2][1] * p[1] + m[2][2] * p[2] + r->camera_dist;
+
+        if (z < r->near_z) { // a corner behind the camera can end up anywhere
+            x0 = y0 = 0;
+            x1 = w - 1;
+            y1 = h - 1;
+            break;
+        }
+        int xp = round(w/2 + r->z1 * x / z * 2), yp = round(h/2 + r->z1 * y / z);
+        if (xp < x0) x0 = xp;
+        if (xp > x1) x1 = xp;
+        if (yp < y0) y0 = yp;
+        if (yp > y1) y1 = yp;
+    }
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > w - 1) x1 = w - 1;
+    if (y1 > h - 1) y1 = h - 1;
+
+    // working out the cells inside the outline that nothing landed in
+    for (int cy = y0; cy <= y1; cy++) {
+        for (int cx = x0; cx <= x1; cx++) {
+            int idx = cx + cy * w;
+            if (r->cells[idx].face >= 0) continue;
+
+            point p;
+            float z;
+            int face = castcell(r, m, cx, cy, &p, &z);
+            if (face < 0) continue;
+
+            float i, j;
+            facecoords(face, p, &i, &j);
+            int type = decaltype(r, face, i, j);
+
+            r->z_buf[idx] = 1/z;
+            shadecell(r, idx, lum[face], type);
+            r->cells[idx] = (cellsample){p, face, type};
+            r->cells_cast++;
+        }
+    }
+}
+
+// whether the camera could be inside the cube, or close enough that the near plane cuts into it. then
+// rays start out inside and no face points towards the camera, so only a full redraw gets it right
+static int cameranear(const renderer *r) {
+    return r->camera_dist < r->cube_width * sqrtf(3) / 2 + r->near_z;
+}
+
+// gets the cell buffers ready for this frame. returns 1 if the last frame's cells can be used
+static int temporalstart(renderer *r) {
+    int n = r->w * r->h;
+
+    if (!r->cells) {
+        r->cells = malloc(n * sizeof(cellsample));
+        r->prev_cells = malloc(n * sizeof(cellsample));
+        if (!r->cells || !r->prev_cells) {
+            free(r->cells);
+            free(r->prev_cells);
+            r->cells = r->prev_cells = NULL;
+            return 0;
+        }
+        r->since_refresh = -1; // nothing to go on yet
+    }
+
+    cellsample *t = r->prev_cells;
+    r->prev_cells = r->cells;
+    r->cells = t;
+    for (int i = 0; i < n; i++) r->cells[i].face = -1;
+
+    int reuse = r->since_refresh >= 0 && r->since_refresh + 1 < r->refresh_every && !cameranear(r) &&
+                r->cached_width == r->cube_width && r->cached_decal == r->decal &&
+                r->cached_shapes == r->shapes_version;
+
+    r->since_refresh = reuse ? r->since_refresh + 1 : 0;
+    r->cached_width = r->cube_width;
+    r->cached_decal = r->decal;
+    r->cached_shapes = r->shapes_version;
+    return reuse;
+}
+
+/*
+    === ray casting ===
+
+    instead of throwing points at the screen and seeing where they land, every cell sends a ray from
+    the camera through its center into the cube's own coordinates and intersects it with the cube
+    (same slab test temporal mode uses for its empty cells). the face it goes in through gives the
+    lighting, the point it goes in at gives (i, j) on that face for the decals.
+
+    with the camera inside the cube (or close enough that the near plane cuts into it), the way in is
+    behind the camera, so the ray takes the face it comes out through instead. that's the inside of a
+    wall, which shows up plain like it does with points, the decals sit just outside it.
+
+    a frame is exactly w * h ray tests, whatever the spacing or zoom, and never has gaps. each cell
+    only writes to itself, so rows can be handed to different threads with no locking at all.
+
+    each row is done in two goes: first the slab tests for the whole row, in a loop with no branches
+    that the compiler can vectorize (the ray directions along a row are a straight line, so they're
+    just base + cx * step), then shading and decals for the cells that hit.
+
+    =================================
+*/
+
+int cube_renderer_cast_start(renderer *r) {
+    if (updatelayers(r) != 0) return -1;
+
+    if (!r->ray_face) {
+        r->ray_face = malloc(r->w * r->h * sizeof(signed char));
+        if (!r->ray_face) return -1;
+    }
+
+    rotation(r, r->ray_m);
+    for (int f = 0; f < 6; f++) {
+        point p, n;
+        faceposition(1 << f, 0, 0, 0, &p, &n);
+        r->ray_lum[f] = lightpoint(r, n.x, n.y, n.z);
+    }
+    return 0;
+}
+
+void cube_renderer_cast_rows(renderer *r, int first, int every) {
+    int w = r->w;
+    float (*m)[3] = r->ray_m;
+    float half = r->cube_width / 2;
+    float near_z = r->near_z;
+
+    // camera in the cube's own coordinates, and how the ray direction moves from one cell to the next
+    float o[3], step[3];
+    for (int a = 0; a < 3; a++) {
+        o[a] = -r->camera_dist * m[2][a];
+        step[a] = m[0][a] / (2 * r->z1);
+    }
+
+    for (int cy = first; cy < r->h; cy += every) {
+        float *z = r->z_buf + cy * w;
+        signed char *hit = r->ray_face + cy * w;
+
+        // direction of the ray through cell (0, cy) (see castcell)
+        float dy = (cy - r->h/2) / r->z1;
+        float base[3];
+        for (int a = 0; a < 3; a++) {
+            base[a] = m[1][a] * dy + m[2][a] - step[a] * (w/2);
+        }
+
+        // slab tests, t goes in z_buf for now
+        for (int cx = 0; cx < w; cx++) {
+            float dir[3] = {base[0] + cx * step[0], base[1] + cx * step[1], base[2] + cx * step[2]};
+            float t;
+            hit[cx] = raytest(o, dir, half, near_z, &t);
+            z[cx] = t;
+        }
+
+        // shading and decals
+        for (int cx = 0; cx < w; cx++) {
+            int face = hit[cx];
+            if (face < 0) {
+                z[cx] = 0;
+                continue;
+            }
+
+            float t = z[cx];
+            point p = {o[0] + t * (base[0] + cx * step[0]),
+                       o[1] + t * (base[1] + cx * step[1]),
+                       o[2] + t * (base[2] + cx * step[2])};
+
+            // from the inside, a face is plain: the decals sit a little outside it and face away
+            int type = NORMAL;
+            if (face >= 6) face -= 6;
+            else if (r->nlayers > 0) {
+                float i, j;
+                facecoords(face, p, &i, &j);
+                type = decaltype(r, face, i, j);
+            }
+
+            z[cx] = 1/t;
+            shadecell(r, cx + cy * w, r->ray_lum[face], type);
+        }
+    }
+}
+
+int cube_renderer_init(renderer *r, int w, int h, int color_mode, int sub_mode) {
+    memset(r, 0, sizeof(*r));
+
+    r->camera_dist = 90;
+    r->z1 = 40;
+    r->lightsource = (point){100, 100, -100};
+    r->cube_width = 50;
+    r->spacing = 0.5;
+    r->decal = NO_DECAL;
+    r->near_z = 1;
+    r->temporal = 0;
+    r->refresh_every = 30;
+    r->tolerance = 0.5;
+    r->raycast = 0;
+
+    r->w = w;
+    r->h = h;
+    r->color_mode = color_mode;
+    r->sub_mode = sub_mode;
+    r->sx = sub_mode == BRAILLE ? 2 : 1;
+    r->sy = sub_mode == BRAILLE ? 4 : (sub_mode == HALFBLOCK ? 2 : 1);
+
+    if (sub_mode != CELL) {
+        r->spacing = 0.5 / (r->sy / 2); // dots are smaller than chars, so points have to be closer together to not leave gaps
+    }
+
+    r->z_buf = malloc(w * h * sizeof(float));
+    r->buf = malloc(w * h * sizeof(char));
+    r->col_buf = malloc(w * h * sizeof(unsigned char));
+    r->render_buf = malloc((w + 1) * h * (SGR_MAX + 3)); // 1 is added for '\n's, room for a color escape + utf-8 glyph per cell
+
+    if (sub_mode != CELL) {
+        r->sub_z = malloc(w * r->sx * h * r->sy * sizeof(float));
+        r->cov = malloc(w * h * sizeof(unsigned char));
+    }
+
+    if (!r->z_buf || !r->buf || !r->col_buf || !r->render_buf || (sub_mode != CELL && (!r->sub_z || !r->cov))) {
+        cube_renderer_free(r);
+        return -1;
+    }
+
+    if (color_mode != MONO) init_colors(r);
+    if (sub_mode != CELL) init_glyphs(r);
+
+    cube_renderer_clear(r);
+    return 0;
+}
+
+void cube_renderer_free(renderer *r) {
+    free(r->z_buf);
+    free(r->buf);
+    free(r->col_buf);
+    free(r->render_buf);
+    free(r->sub_z);
+    free(r->cov);
+    free(r->cells);
+    free(r->prev_cells);
+    free(r->ray_face);
+    freelayers(r);
+
+    r->z_buf = r->sub_z = NULL;
+    r->buf = r->render_buf = NULL;
+    r->col_buf = r->cov = NULL;
+    r->cells = r->prev_cells = NULL;
+    r->ray_face = NULL;
+}
+
+void cube_renderer_clear(renderer *r) {
+    int n = r->w * r->h;
+
+    memset(r->buf, bg, n * sizeof(char));
+    memset(r->z_buf, 0, n * sizeof(float));
+    memset(r->col_buf, 0, n * sizeof(unsigned char));
+
+    if (r->sub_mode != CELL) {
+        memset(r->sub_z, 0, n * r->sx * r->sy * sizeof(float));
+        memset(r->cov, 0, n * sizeof(unsigned char));
+    }
+}
+
+void cube_renderer_draw(renderer *r, int faces) {
+    float cube_width = r->cube_width;
+    float spacing = r->spacing;
+
+    if (updatelayers(r) != 0) return; // out of memory
+
+    if (r->raycast && r->sub_mode == CELL && faces == ALL_FACES) {
+        if (r->cells) r->since_refresh = -1; // the cells won't match what gets drawn now
+        if (cube_renderer_cast_start(r) == 0) cube_renderer_cast_rows(r, 0, 1);
+        return;
+    }
+
+    if (r->temporal && r->sub_mode == CELL && faces == ALL_FACES) {
+        if (temporalstart(r)) {
+            drawtemporal(r);
+            return;
+        }
+        // otherwise a normal full redraw, which fills in the cells for next time
+    }
+    else if (r->cells) {
+        r->since_refresh = -1; // the cells won't match what gets drawn now
+    }
+
+    // faces that can't show up at all don't need any of their points calculated
+    for (int f = FRONT; f <= BOTTOM; f <<= 1) {
+        if ((faces & f) && faceoffscreen(r, f)) faces &= ~f;
+    }
+    if (!faces) return;
+
+    // sides of the cube
+    for (float i = -cube_width/2; i <= cube_width/2; i += spacing) {
+        for (float j = -cube_width/2; j <= cube_width/2; j += spacing) {
+            for (int f = FRONT; f <= BOTTOM; f <<= 1) {
+                if (faces & f) facepoint(r, f, i, j, cube_width/2, NORMAL);
+            }
+        }
+    }
+
+    if (r->nlayers == 0) return;
+
+    // decals, each shape in turn. the preset decal sits 0.1 out from the faces (a hole never blocks anything,
+    // so the heart can share that with the circle it goes in), every added shape another 0.1 further out.
+    // points of two layers don't land in exactly the same places, so a tie in depth wouldn't be enough
+    // to put an added shape on top of what's under it
+    int preset = r->nlayers - r->nshapes;
+    for (int l = 0; l < r->nlayers; l++) {
+        const shapepoints *sp = &r->layers[l];
+        float d = cube_width/2 + 0.1 * (l < preset ? 1 : l - preset + 2);
+
+        for (int p = 0; p < sp->count; p++) {
+            float i = sp->uv[2 * p], j = sp->uv[2 * p + 1];
+
+            for (int f = FRONT; f <= BOTTOM; f <<= 1) {
+                float v = (sp->s.flip_sides && f != TOP && f != BOTTOM) ? -j : j;
+                if (faces & f) facepoint(r, f, i, v, d, sp->s.type);
+            }
+        }
+    }
+}
+
+void cube_renderer_merge(renderer *dst, const renderer *src) {
+    int w = dst->w, h = dst->h;
+
+    if (dst->sub_mode == CELL) {
+        for (int i = 0; i < w * h; i++) {
+            if (src->z_buf[i] > dst->z_buf[i]) {
+                dst->z_buf[i] = src->z_buf[i];
+                dst->buf[i] = src->buf[i];
+                dst->col_buf[i] = src->col_buf[i];
+            }
+        }
+        return;
+    }
+
+    int sx = dst->sx, sy = dst->sy;
+
+    for (int dy = 0; dy < h * sy; dy++) {
+        for (int dx = 0; dx < w * sx; dx++) {
+            int didx = dx + dy * w * sx;
+            if (src->sub_z[didx] <= dst->sub_z[didx]) continue;
+
+            int cell = dx / sx + (dy / sy) * w;
+            unsigned char bit = dot_bit(dst, dx, dy);
+
+            dst->sub_z[didx] = src->sub_z[didx];
+            dst->cov[cell] = (dst->cov[cell] & ~bit) | (src->cov[cell] & bit);
+            dst->col_buf[cell] = src->col_buf[cell];
+        }
+    }
+}
+
+size_t cube_renderer_frame(renderer *r) {
+    int w = r->w, h = r->h;
+    char *out = r->render_buf;
+
+    // putting contents of buf[] into render_buf[] (with a color escape wherever the color changes)
+
+    size_t k = 0;
+    int cur = 0; // color the terminal is on (0 -> unknown, so the first colored cell always sets it)
+    for (int j = 0; j < h; j++) {
+        for (int i = 0; i < w; i++) {
+            int col = r->col_buf[i + j*w];
+
+            if (r->sub_mode != CELL && !r->cov[i + j*w]) col = 0; // blank, no point switching colors for it
+
+            if (r->color_mode != MONO && col && col != cur) {
+                memcpy(out + k, r->sgr[col], r->sgr_len[col]);
+                k += r->sgr_len[col];
+                cur = col;
+            }
+
+            if (r->sub_mode == CELL) {
+                out[k++] = r->buf[i + j*w];
+            }
+            else {
+                int bits = r->cov[i + j*w];
+                memcpy(out + k, r->glyphs[bits], r->glyph_len[bits]);
+                k += r->glyph_len[bits];
+            }
+        }
+        out[k++] = '\n';
+    }
+    return k;
+}
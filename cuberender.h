@@ -0,0 +1,211 @@
+#ifndef CUBERENDER_H
+#define CUBERENDER_H
+
+#include <stddef.h>
+
+/*
+    === renderer ===
+
+    everything companioncube.c used to keep in globals (angles, camera, light, z_buf, buf, ...)
+    lives in a renderer instead, so one process can have as many cubes going as it wants,
+    each on its own thread if it likes, without any locking.
+
+    typical use:
+
+        cube_renderer r;
+        cube_renderer_init(&r, 150, 55, CUBE_MONO, CUBE_CELL);
+        r.decal = CUBE_HEART;
+
+        while (...) {
+            cube_renderer_clear(&r);
+            cube_renderer_draw(&r, CUBE_ALL_FACES);
+            size_t len = cube_renderer_frame(&r);   // frame is in r.render_buf
+            ...
+            r.A += 0.1;
+        }
+
+        cube_renderer_free(&r);
+
+    the settings at the top of the struct can be changed between frames.
+    the rest is set up by cube_renderer_init and shouldn't be touched.
+
+    everything in here starts with cube_ or CUBE_, so it can be included next to whatever
+    the host program already has. cuberender.c uses shorter names for the same things.
+
+    =================================
+*/
+
+#define CUBE_NORMAL 0
+#define CUBE_SHINY 1
+#define CUBE_HOLE 2
+
+// color modes
+#define CUBE_MONO 0
+#define CUBE_COLOR256 1
+#define CUBE_TRUECOLOR 2
+
+// sub-cell modes
+#define CUBE_CELL 0
+#define CUBE_BRAILLE 1
+#define CUBE_HALFBLOCK 2
+
+// what's drawn on each face (on top of these, any shapes added with cube_renderer_add_shape)
+#define CUBE_NO_DECAL 0
+#define CUBE_CIRCLE 1    // shiny circle (cubecircle)
+#define CUBE_HEART 2     // hole with a shiny heart in it (companioncube)
+
+// what a shape's bound test can say about a box
+#define CUBE_OUTSIDE 0
+#define CUBE_INSIDE 1
+#define CUBE_EDGE 2      // could be either, the points in it get tested one by one
+
+#define CUBE_MAX_SHAPES 8
+
+// faces, for picking which ones cube_renderer_draw does
+#define CUBE_FRONT   0x01
+#define CUBE_BACK    0x02
+#define CUBE_RIGHT   0x04
+#define CUBE_LEFT    0x08
+#define CUBE_TOP     0x10
+#define CUBE_BOTTOM  0x20
+#define CUBE_ALL_FACES 0x3F
+
+#define CUBE_LEVELS 24   // brightness levels per color ramp (the 256-color palette has exactly 24 grays)
+#define CUBE_SGR_MAX 24  // longest color escape ("\x1b[38;2;255;255;255m" + some room)
+
+typedef struct {
+    float x, y, z;
+} cube_point;
+
+/*
+    === shapes ===
+
+    a decal is any shape given by an inside test on face coordinates (u, v), u and v going from -extent
+    to extent. the bound test is optional: given a box, it says whether the shape covers all of it,
+    none of it, or some (interval arithmetic on the inside test usually does the job). with it, the
+    points of a face don't have to be tested one by one, only the ones near the shape's edge are.
+
+    the points that are inside only get worked out again when the spacing or the cube changes, not
+    every frame.
+
+    =================================
+*/
+
+typedef struct cube_shape cube_shape;
+
+struct cube_shape {
+    int (*inside)(const cube_shape *s, float u, float v);
+    int (*bound)(const cube_shape *s, float u0, float v0, float u1, float v1); // CUBE_OUTSIDE, CUBE_INSIDE or CUBE_EDGE. can be NULL
+    const void *data;       // for the two functions, if they need anything else
+    float extent;           // the shape fits in [-extent, extent] x [-extent, extent]
+    int type;               // CUBE_SHINY or CUBE_HOLE
+    int flip_sides;         // turn it upside down on the 4 side faces (so e.g. the heart is upright on all of them)
+};
+
+// the two built-in ones
+cube_shape cube_circle_shape(float radius, int type);
+cube_shape cube_heart_shape(float size, int type);
+
+typedef struct {
+    cube_shape s;
+    float *uv;              // (u, v) of every point that's inside, same order as a plain loop over u then v
+    int count;
+} cube_shapepoints;
+
+// what a cell was made from, kept around between frames in temporal mode
+typedef struct {
+    cube_point p;           // where on the cube (before rotation) the cell's point is
+    signed char face;       // which face it's on (0..5 for CUBE_FRONT..CUBE_BOTTOM, -1 for nothing)
+    unsigned char type;     // CUBE_NORMAL, CUBE_SHINY or CUBE_HOLE
+} cube_cellsample;
+
+typedef struct {
+    // === settings ===
+    float A, B, C;          // angles (A -> x-axis | B -> y-axis | C -> z-axis)
+    float camera_dist;
+    float z1;               // essentially z', used in projection formula
+    cube_point lightsource;
+    float cube_width;       // how big the cube will look
+    float spacing;          // distance between points on a face
+    int decal;
+    float near_z;           // points closer to the camera than this are skipped
+
+    // temporal mode (CUBE_CELL mode, CUBE_ALL_FACES only): instead of redrawing everything, the cells of the last
+    // frame are moved to where they'd be now, and only the ones that come out empty are worked out again
+    int temporal;
+    int refresh_every;      // redraw everything every this many frames anyway, so small errors can't stick around
+    float tolerance;        // how far (in cells, 0 to 0.5) a moved point can land from a cell's center and still be used.
+                            // lower -> fewer cells reused, closer to a full redraw
+
+    // ray cast mode (CUBE_CELL mode, CUBE_ALL_FACES only): one ray per cell intersected with the cube, instead of points.
+    // no gaps at any zoom, and always w * h rays whatever the spacing. takes over from temporal mode when both are on
+    int raycast;
+
+    // === set up by cube_renderer_init ===
+    int w, h;
+    int color_mode, sub_mode;
+    int sx, sy;             // dots per char (1x1 in CUBE_CELL mode)
+
+    float *z_buf;           // stores z values of points (for depth perception effects)
+    char *buf;              // stores characters to print
+    unsigned char *col_buf; // color of each cell (0 -> no color, otherwise an index into sgr[])
+    float *sub_z;           // z values at dot resolution (sub-cell modes only)
+    unsigned char *cov;     // which dots of each char are lit, one bit per dot (sub-cell modes only)
+    char *render_buf;       // the frame, filled in by cube_renderer_frame
+
+    cube_cellsample *cells, *prev_cells; // this frame's / last frame's cells (temporal mode only)
+    int since_refresh;      // frames since the last full redraw
+    float cached_width;     // cube_width and decals the cells were made with
+    int cached_decal, cached_shapes;
+    int cells_reused, cells_cast;   // how the last temporal frame was made (moved over vs worked out again)
+
+    float ray_m[3][3];      // this frame's rotation (ray cast mode, set by cube_renderer_cast_start)
+    float ray_lum[6];       // and lighting of each face
+    signed char *ray_face;  // face each cell's ray went in through
+
+    cube_shape shapes[CUBE_MAX_SHAPES];     // added with cube_renderer_add_shape
+    int nshapes;
+    int shapes_version;             // goes up whenever shapes change
+
+    cube_shapepoints layers[CUBE_MAX_SHAPES + 2]; // the points of every decal (preset ones first), drawn in this order
+    int nlayers;
+    float layers_spacing, layers_width; // what the layers were worked out for
+    int layers_decal, layers_version;
+    long shape_tests;       // inside + bound tests it took to work the layers out
+
+    char sgr[1 + 2 * CUBE_LEVELS][CUBE_SGR_MAX]; // escape for each color: 1..CUBE_LEVELS -> body (gray), CUBE_LEVELS+1.. -> heart (pink)
+    int sgr_len[1 + 2 * CUBE_LEVELS];
+    char glyphs[256][4];    // utf-8 for each dot pattern
+    int glyph_len[256];
+} cube_renderer;
+
+// allocates the buffers and sets everything to the defaults companioncube.c always used. returns -1 if out of memory
+int cube_renderer_init(cube_renderer *r, int w, int h, int color_mode, int sub_mode);
+void cube_renderer_free(cube_renderer *r);
+
+// clears buf/z_buf (and the color/dot buffers) for a new frame
+void cube_renderer_clear(cube_renderer *r);
+
+// adds a decal shape to every face, drawn after (on top of) the preset decal and earlier shapes. returns -1 if full
+int cube_renderer_add_shape(cube_renderer *r, const cube_shape *s);
+void cube_renderer_clear_shapes(cube_renderer *r);
+
+// loads the given faces (CUBE_ALL_FACES, or e.g. CUBE_FRONT | CUBE_BACK) and their decals into the buffers
+void cube_renderer_draw(cube_renderer *r, int faces);
+
+// ray cast mode spread over threads: cube_renderer_cast_start once per frame, then cube_renderer_cast_rows
+// from each thread with the same every and a different first. cube_renderer_draw does both itself when
+// raycast is set.
+// returns -1 if out of memory
+int cube_renderer_cast_start(cube_renderer *r);
+
+// casts rows first, first + every, first + 2 * every, ... (different rows share nothing, so no locking needed)
+void cube_renderer_cast_rows(cube_renderer *r, int first, int every);
+
+// copies over every cell (or dot) of src that's closer than what dst has. both need the same size and modes
+void cube_renderer_merge(cube_renderer *dst, const cube_renderer *src);
+
+// puts the buffers together into render_buf and returns its length
+size_t cube_renderer_frame(cube_renderer *r);
+
+#endif
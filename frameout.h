@@ -0,0 +1,177 @@
+#ifndef FRAMEOUT_H
+#define FRAMEOUT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+/*
+    === frame output ===
+
+    frames skip stdio and go straight to the fd with writev(). the home escape and the
+    frame are handed over in a single call, and partial writes carry on from where they stopped.
+
+    with nonblocking set, the fd is put into O_NONBLOCK mode. when the terminal can't keep up:
+        - a frame that was only partly written gets finished first (so the screen doesn't tear)
+        - any new frame that shows up while that's going on, or that can't even start, is dropped
+    so the renderer never waits on the terminal. the drop count is printed when the program exits.
+
+    =================================
+*/
+
+static const char home_esc[] = "\x1b[H"; // ANSI code to tell the cursor to return to the start position
+
+typedef struct {
+    int fd;
+    int nonblocking;
+    int old_flags;
+
+    char *pending;      // rest of a frame that didn't fully make it out
+    size_t pending_len, pending_off, pending_cap;
+
+    unsigned long frames_written;
+    unsigned long frames_dropped;
+    unsigned long long bytes_written;
+} frameout;
+
+// the frame loops run until ctrl-c instead of forever, so stdout can be put back and the stats printed
+static volatile sig_atomic_t running = 1;
+
+static void stop_running(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+static void frameout_init(frameout *o, int fd, int nonblocking) {
+    memset(o, 0, sizeof(*o));
+    o->fd = fd;
+    o->nonblocking = nonblocking;
+    o->old_flags = fcntl(fd, F_GETFL);
+
+    if (nonblocking && o->old_flags != -1) {
+        fcntl(fd, F_SETFL, o->old_flags | O_NONBLOCK);
+    }
+
+    signal(SIGINT, stop_running);
+    signal(SIGTERM, stop_running);
+}
+
+// keeps a copy of whatever is left of the current frame (iov[0..cnt-1]) so it can be finished later.
+// returns -1 if there's no memory for it
+static int frameout_keep(frameout *o, struct iovec *iov, int cnt) {
+    size_t len = 0;
+    for (int i = 0; i < cnt; i++) len += iov[i].iov_len;
+
+    if (len > o->pending_cap) {
+        char *p = realloc(o->pending, len);
+        if (!p) return -1; // the old buffer is still there (and still freed in frameout_close)
+        o->pending = p;
+        o->pending_cap = len;
+    }
+
+    size_t k = 0;
+    for (int i = 0; i < cnt; i++) {
+        memcpy(o->pending + k, iov[i].iov_base, iov[i].iov_len);
+        k += iov[i].iov_len;
+    }
+    o->pending_len = len;
+    o->pending_off = 0;
+    return 0;
+}
+
+// writes as much of *iov as the fd will take, moving *iov and *cnt past what got out.
+// returns bytes written, or -1 on a real error
+static ssize_t frameout_writev(frameout *o, struct iovec **iov, int *cnt) {
+    ssize_t total = 0;
+
+    while (*cnt > 0) {
+        ssize_t n = writev(o->fd, *iov, *cnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return -1;
+        }
+        total += n;
+        o->bytes_written += n;
+
+        // stepping past whatever got written (a partial write can stop in the middle of an entry)
+        while (*cnt > 0 && (size_t)n >= (*iov)->iov_len) {
+            n -= (*iov)->iov_len;
+            (*iov)++;
+            (*cnt)--;
+        }
+        if (*cnt > 0) {
+            (*iov)->iov_base = (char *)(*iov)->iov_base + n;
+            (*iov)->iov_len -= n;
+        }
+    }
+    return total;
+}
+
+// tries to finish the leftover part of the last frame. returns 1 once nothing is left
+static int frameout_flush(frameout *o) {
+    if (o->pending_off >= o->pending_len) return 1;
+
+    struct iovec iov = {o->pending + o->pending_off, o->pending_len - o->pending_off};
+    struct iovec *left = &iov;
+    int cnt = 1;
+    ssize_t n = frameout_writev(o, &left, &cnt);
+    if (n > 0) o->pending_off += n;
+
+    return o->pending_off >= o->pending_len;
+}
+
+// sends out the home escape + frame. returns 1 if the frame went out (or will, once the tty drains), 0 if it was dropped,
+// -1 on a write error
+static int frameout_write(frameout *o, const char *frame, size_t len) {
+    if (!frameout_flush(o)) {
+        o->frames_dropped++;
+        return 0;
+    }
+
+    struct iovec iov[2] = {
+        {(void *)home_esc, sizeof(home_esc) - 1},
+        {(void *)frame, len}
+    };
+    struct iovec *left = iov;
+    int cnt = 2;
+
+    ssize_t n = frameout_writev(o, &left, &cnt);
+    if (n < 0) return -1;
+
+    if (cnt > 0) {
+        if (n == 0) { // terminal didn't take a single byte, so nothing is lost by skipping this one
+            o->frames_dropped++;
+            return 0;
+        }
+        if (frameout_keep(o, left, cnt) != 0) { // the rest is lost, the next frame starts with home_esc and covers it up
+            o->frames_dropped++;
+            return 0;
+        }
+    }
+
+    o->frames_written++;
+    return 1;
+}
+
+// finishes the last frame, puts the fd back the way it was and prints the stats
+static void frameout_close(frameout *o) {
+    if (o->nonblocking && o->old_flags != -1) {
+        fcntl(o->fd, F_SETFL, o->old_flags);
+    }
+    frameout_flush(o);
+
+    fprintf(stderr, "\nframes: %lu written, %lu dropped, %.0f bytes/frame\n",
+            o->frames_written, o->frames_dropped,
+            o->frames_written ? (double)o->bytes_written / o->frames_written : 0.0);
+
+    free(o->pending);
+    o->pending = NULL;
+}
+
+#endif
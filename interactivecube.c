@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+#include <termios.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#include "frameout.h"
+#include "cuberender.h"
+
+#define W 150
+#define H 55
+
+/*
+    === interactive cube ===
+
+    instead of a while (1) that spins the cube and sleeps, this waits on two things with epoll:
+        - a timerfd that goes off once per frame period, which turns the cube a bit and draws a frame
+        - the keyboard (stdin in non-canonical mode), which is read without ever blocking
+
+    keys:
+        w / s       tilt (A)            + / -   zoom (camera_dist)
+        a / d       turn (B)            space   pause / unpause the spinning
+        z / x       roll (C)            m       char / braille / half block
+        q           quit                c       mono / 256 colors / truecolor
+
+    every key is timestamped as soon as it's read, and a frame showing it is drawn right away (not on
+    the next tick). once that frame has been handed to the terminal the time it took is recorded, and
+    the p50/p99 get printed at the end next to the frame period they should stay under.
+    (braille/half block can't use temporal mode, so they take a lot longer per frame than char mode)
+
+    usage: ./interactivecube [-f fps] [-n]
+
+    =================================
+*/
+
+typedef struct {
+    double *ms;
+    int count, cap;
+} latencies;
+
+struct termios old_term;
+int have_term = 0;      // stdin is a terminal (and not e.g. a pipe of keys)
+
+double now_ms() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e3 + t.tv_nsec / 1e6;
+}
+
+void record(latencies *l, double ms) {
+    if (l->count == l->cap) {
+        l->cap = l->cap ? l->cap * 2 : 256;
+        l->ms = realloc(l->ms, l->cap * sizeof(double));
+    }
+    l->ms[l->count++] = ms;
+}
+
+int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// keys come in one byte at a time and show up right away (no waiting for enter), ctrl-c still works
+void raw_input(int on) {
+    if (on) {
+        if (tcgetattr(STDIN_FILENO, &old_term) != 0) return;
+        have_term = 1;
+
+        struct termios t = old_term;
+        t.c_lflag &= ~(ICANON | ECHO);
+        t.c_cc[VMIN] = 0;
+        t.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &t);
+    }
+    else if (have_term) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &old_term);
+    }
+}
+
+// swaps the renderer for one with different modes, keeping the camera and angles
+int switch_modes(cube_renderer *r, int color_mode, int sub_mode) {
+    cube_renderer next;
+    if (cube_renderer_init(&next, W, H, color_mode, sub_mode) != 0) return -1;
+
+    next.A = r->A;
+    next.B = r->B;
+    next.C = r->C;
+    next.camera_dist = r->camera_dist;
+    next.decal = r->decal;
+    next.temporal = r->temporal;
+
+    cube_renderer_free(r);
+    *r = next;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+
+    int nonblocking = 0;
+    double fps = 60;
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-n") == 0) nonblocking = 1; // don't wait on a slow terminal, drop frames instead
+        else if (strcmp(argv[a], "-f") == 0 && a + 1 < argc) fps = atof(argv[++a]);
+    }
+    if (fps <= 0) fps = 60;
+
+    int color_mode = CUBE_MONO, sub_mode = CUBE_CELL;
+
+    cube_renderer r;
+    if (cube_renderer_init(&r, W, H, color_mode, sub_mode) != 0) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    r.decal = CUBE_HEART;
+    r.temporal = 1; // most frames are just the last one turned a bit (see cuberender.h), keeps key -> frame short
+
+    // ticks once per frame period
+    long period_ns = 1e9 / fps;
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (tfd < 0) {
+        perror("timerfd_create");
+        return 1;
+    }
+    struct itimerspec spec = {{period_ns / 1000000000, period_ns % 1000000000}, {period_ns / 1000000000, period_ns % 1000000000}};
+    if (timerfd_settime(tfd, 0, &spec, NULL) != 0) {
+        perror("timerfd_settime");
+        return 1;
+    }
+
+    int ep = epoll_create1(0);
+    if (ep < 0) {
+        perror("epoll_create1");
+        return 1;
+    }
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = tfd};
+    if (epoll_ctl(ep, EPOLL_CTL_ADD, tfd, &ev) != 0) {
+        perror("epoll_ctl (timer)");
+        return 1;
+    }
+
+    // stdin can't always be waited on (epoll says EPERM for a regular file, like ./interactivecube < file).
+    // then it just spins on the timer, with no keys
+    ev.data.fd = STDIN_FILENO;
+    if (epoll_ctl(ep, EPOLL_CTL_ADD, STDIN_FILENO, &ev) != 0) {
+        perror("epoll_ctl (stdin)");
+        fprintf(stderr, "no keys, ctrl-c to quit\n");
+    }
+
+    raw_input(1);
+
+    printf("\x1b[2J"); // ANSI code to clear terminal
+    fflush(stdout);
+
+    frameout out;
+    frameout_init(&out, STDOUT_FILENO, nonblocking);
+
+    latencies lat = {0};
+    double pending[64];     // when each key that isn't on screen yet came in
+    int npending = 0;
+    int paused = 0;
+    int reset_colors = 0;   // back in mono mode, the terminal still has the last color on
+
+    while (running) {
+        struct epoll_event events[2];
+        int n = epoll_wait(ep, events, 2, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        int draw = 0;
+
+        for (int e = 0; e < n; e++) {
+            if (events[e].data.fd == tfd) {
+                uint64_t ticks;
+                if (read(tfd, &ticks, sizeof(ticks)) != sizeof(ticks)) continue;
+
+                // changing angles so that the cube rotates (once per tick, so missed ticks catch up)
+                if (!paused) {
+                    r.A += 0.1 * ticks;
+                    r.B += 0.1 * ticks;
+                    r.C += 0.01 * ticks;
+                    draw = 1;
+                }
+                continue;
+            }
+
+            char keys[64];
+            ssize_t got = read(STDIN_FILENO, keys, sizeof(keys));
+            if (got <= 0) {
+                if (got == 0) running = 0; // stdin closed
+                continue;
+            }
+            double t = now_ms();
+
+            for (int k = 0; k < got; k++) {
+                int changed = 1;
+                switch (keys[k]) {
+                    case 'w': r.A -= 0.1; break;
+                    case 's': r.A += 0.1; break;
+                    case 'a': r.B -= 0.1; break;
+                    case 'd': r.B += 0.1; break;
+                    case 'z': r.C -= 0.1; break;
+                    case 'x': r.C += 0.1; break;
+                    case '+': case '=': {
+                        // not into the cube (its corners are cube_width * sqrt(3) / 2 out), where temporal mode can't help
+                        float closest = r.cube_width * sqrt(3) / 2 + r.near_z;
+                        r.camera_dist = r.camera_dist - 5 > closest ? r.camera_dist - 5 : closest;
+                        break;
+                    }
+                    case '-': case '_': r.camera_dist += 5; break;
+                    case ' ': paused = !paused; break;
+                    case 'm':
+                        sub_mode = (sub_mode + 1) % 3;
+                        changed = switch_modes(&r, color_mode, sub_mode) == 0;
+                        break;
+                    case 'c':
+                        color_mode = (color_mode + 1) % 3;
+                        changed = switch_modes(&r, color_mode, sub_mode) == 0;
+                        if (color_mode == CUBE_MONO) reset_colors = 1;
+                        break;
+                    case 'q': running = 0; changed = 0; break;
+                    default: changed = 0;
+                }
+
+                if (changed && npending < 64) pending[npending++] = t;
+                draw |= changed;
+            }
+        }
+
+        if (!draw || !running) continue;
+
+        cube_renderer_clear(&r);
+        cube_renderer_draw(&r, CUBE_ALL_FACES);
+        size_t k = cube_renderer_frame(&r);
+
+        // the color reset goes out in front of the frame, so it can't get dropped on its own or counted as a frame
+        // (mono frames are far smaller than render_buf, there's room)
+        if (reset_colors) {
+            memmove(r.render_buf + 4, r.render_buf, k);
+            memcpy(r.render_buf, "\x1b[0m", 4);
+            k += 4;
+        }
+
+        // home escape + frame go out in one write (or get dropped if the terminal is behind, see frameout.h)
+        if (frameout_write(&out, r.render_buf, k) == 1) {
+            reset_colors = 0;
+            double t = now_ms();
+            for (int i = 0; i < npending; i++) {
+                record(&lat, t - pending[i]);
+            }
+            npending = 0;
+        }
+        // a dropped frame keeps the keys pending, the next frame that makes it out is the one that shows them
+    }
+
+    frameout_close(&out);
+    raw_input(0);
+    printf("\x1b[0m"); // back to the terminal's own colors
+    fflush(stdout);
+
+    if (lat.count > 0) {
+        qsort(lat.ms, lat.count, sizeof(double), cmp_double);
+        fprintf(stderr, "input -> frame: %d keys, p50 %.2fms, p99 %.2fms (frame period %.2fms)\n",
+                lat.count, lat.ms[lat.count / 2], lat.ms[(lat.count * 99) / 100], 1000 / fps);
+    }
+
+    close(ep);
+    close(tfd);
+    free(lat.ms);
+    cube_renderer_free(&r);
+    return 0;
+}